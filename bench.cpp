@@ -0,0 +1,314 @@
+/**
+ * Измерение производительности кодирования/декодирования.
+ * Перебираются тип внутреннего символа (u8/u32/u64), R, размер символа, режим (систематический или нет)
+ * и количество стертых символов 0..R; отдельно - коды с внешними матрицами из текстового файла.
+ * Запуск: bench [--json] [--min-ms T] [--h example_ldpc_small.txt]
+ */
+
+#include <algorithm> // std::max
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono
+#include <cstdio>    // std::printf
+#include <cstdlib>   // std::malloc, std::free
+#include <cstring>   // std::strcmp
+#include <iostream>  // std::cout
+#include <new>       // std::bad_alloc
+#include <random>    // std::mt19937
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "hamming.hpp"
+
+// Подсчет выделений памяти: глобальные operator new/delete заменены счетчиком. Замены не встраиваются,
+// иначе GCC видит пару new/free в встроенных путях контейнеров и выдает -Wmismatched-new-delete.
+static std::atomic< std::size_t > gAllocations{ 0 };
+
+__attribute__(( noinline )) void* operator new( std::size_t size )
+{
+   gAllocations.fetch_add( 1, std::memory_order_relaxed );
+   if( void* p = std::malloc( size ? size : 1 ) )
+      return p;
+   throw std::bad_alloc();
+}
+
+__attribute__(( noinline )) void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+__attribute__(( noinline )) void operator delete( void* p, std::size_t ) noexcept
+{
+   std::free( p );
+}
+
+namespace
+{
+
+using namespace hamming;
+
+struct Options
+{
+   bool mJson = false;
+
+   double mMinSeconds = 0.01;
+
+   std::string mCustomPath;
+};
+
+/**
+ * Результат одного измерения.
+ */
+struct Record
+{
+   std::string mOperation;
+
+   std::string mCode;
+
+   std::string mType;
+
+   int mR = 0;
+
+   int mN = 0;
+
+   std::size_t mSymbolBytes = 0;
+
+   bool mIsSystematic = true;
+
+   int mErasures = 0;
+
+   bool mIsOk = true;
+
+   double mNsPerCodeword = 0;
+
+   double mMBps = 0;
+
+   double mAllocsPerCall = 0;
+};
+
+/**
+ * Выполнять f() не меньше min_seconds; заполняет время на вызов и количество выделений памяти на вызов.
+ * Пропускная способность считается по информационным байтам кодового слова.
+ */
+template< typename F >
+void Measure( Record& record, std::size_t info_bytes, double min_seconds, F&& f )
+{
+   f(); // Прогрев: кэш планов, буферы потока.
+   std::size_t calls = 0;
+   const std::size_t allocations = gAllocations.load();
+   const auto start = std::chrono::steady_clock::now();
+   std::chrono::duration< double > elapsed{ 0 };
+   for( std::size_t batch = 1; elapsed.count() < min_seconds; batch *= 2 )
+   {
+      for( std::size_t i = 0; i < batch; ++i )
+         f();
+      calls += batch;
+      elapsed = std::chrono::steady_clock::now() - start;
+   }
+   record.mNsPerCodeword = elapsed.count() * 1e9 / calls;
+   record.mMBps = double( info_bytes ) * calls / elapsed.count() * 1e-6;
+   record.mAllocsPerCall = double( gAllocations.load() - allocations ) / calls;
+}
+
+/**
+ * Вычесть из измерения служебную часть вызова (например, копирование входа), измеренную отдельно.
+ */
+void SubtractBaseline( Record& record, const Record& baseline, std::size_t info_bytes )
+{
+   record.mNsPerCodeword = std::max( record.mNsPerCodeword - baseline.mNsPerCodeword, 0.0 );
+   record.mMBps = record.mNsPerCodeword > 0 ? double( info_bytes ) / record.mNsPerCodeword * 1e3 : 0;
+   record.mAllocsPerCall = std::max( record.mAllocsPerCall - baseline.mAllocsPerCall, 0.0 );
+}
+
+template< typename T >
+const char* TypeName()
+{
+   if constexpr( sizeof( T ) == 1 )
+      return "u8";
+   else if constexpr( sizeof( T ) == 4 )
+      return "u32";
+   else
+      return "u64";
+}
+
+/**
+ * Все измерения для одного кода: кодирование (CodeWord и указатели) и декодирование для 0..R стертых символов.
+ */
+template< typename T, int R, int M >
+void BenchCode( HammingExtended< T, R, M >& code, const std::string& name, const Options& options,
+                std::vector< Record >& records )
+{
+   constexpr std::size_t bytes = sizeof( T ) * M;
+   const std::size_t info_bytes = bytes * code.K;
+   std::mt19937 gen( R * 1000 + M );
+   for( int sys = 1; sys >= 0; --sys )
+   {
+      code.SwitchToSystematic( sys );
+      Record base;
+      base.mCode = name;
+      base.mType = TypeName< T >();
+      base.mR = R;
+      base.mN = code.N;
+      base.mSymbolBytes = bytes;
+      base.mIsSystematic = sys;
+      CodeWord< T, M > a( code.K, { .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+      for( auto& el : a )
+         for( auto& x : el.mSymbol )
+            x = T( gen() );
+      auto s = code.Encode( a );
+      {
+         Record record = base;
+         record.mOperation = "encode";
+         Measure( record, info_bytes, options.mMinSeconds, [&] { s = code.Encode( a ); } );
+         records.push_back( record );
+      }
+      std::vector< std::byte* > symbols( code.N );
+      for( int j = 0; j < code.N; ++j )
+         symbols[ j ] = reinterpret_cast< std::byte* >( s[ j ].mSymbol.data() );
+      {
+         Record record = base;
+         record.mOperation = "encode_symbols";
+         Measure( record, info_bytes, options.mMinSeconds, [&] { code.EncodeSymbols( symbols, bytes ); } );
+         records.push_back( record );
+      }
+      for( int e = 0; e <= R; ++e )
+      {
+         // Фиксированный случайный набор стираний кратности e.
+         std::vector< std::uint64_t > erasures( ( code.N + 63 ) / 64 );
+         auto received = s;
+         for( int count = 0; count < e; )
+         {
+            const int p = gen() % code.N;
+            if( ( erasures[ p / 64 ] >> ( p % 64 ) ) & 1 )
+               continue;
+            erasures[ p / 64 ] |= std::uint64_t( 1 ) << ( p % 64 );
+            received[ p ] = { .mStatus = SymbolStatus::Erased, .mSymbol = {} };
+            ++count;
+         }
+         auto v = received;
+         int erased;
+         int was_changed_strategy;
+         Record record = base;
+         record.mOperation = "decode";
+         record.mErasures = e;
+         record.mIsOk = code.Decode( v, erased, was_changed_strategy );
+         // Decode укорачивает и переставляет вектор, поэтому вход восстанавливается копией;
+         // время копии измеряется отдельно и вычитается.
+         Record copy = record;
+         Measure( copy, info_bytes, options.mMinSeconds, [&] { v = received; } );
+         Measure( record, info_bytes, options.mMinSeconds, [&] {
+            v = received;
+            code.Decode( v, erased, was_changed_strategy );
+         } );
+         SubtractBaseline( record, copy, info_bytes );
+         records.push_back( record );
+         record.mOperation = "decode_symbols";
+         record.mIsOk = code.DecodeSymbols( symbols, erasures, bytes, erased );
+         Measure( record, info_bytes, options.mMinSeconds,
+                  [&] { code.DecodeSymbols( symbols, erasures, bytes, erased ); } );
+         records.push_back( record );
+      }
+   }
+}
+
+template< typename T, int R, int M >
+void BenchBuiltin( const Options& options, std::vector< Record >& records )
+{
+   HammingExtended< T, R, M > code;
+   BenchCode( code, "builtin", options, records );
+}
+
+template< typename T, int R >
+void BenchSymbolSizes( const Options& options, std::vector< Record >& records )
+{
+   BenchBuiltin< T, R, 64 / sizeof( T ) >( options, records );
+   BenchBuiltin< T, R, 4096 / sizeof( T ) >( options, records );
+}
+
+template< typename T >
+void BenchType( const Options& options, std::vector< Record >& records )
+{
+   BenchSymbolSizes< T, 4 >( options, records );
+   BenchSymbolSizes< T, 6 >( options, records );
+   BenchSymbolSizes< T, 8 >( options, records );
+   BenchSymbolSizes< T, 10 >( options, records );
+}
+
+/**
+ * Наибольшее R кода с внешней матрицей (см. DispatchParityCount).
+ */
+constexpr int kMaxCustomR = 24;
+
+void BenchCustom( const CodeDescriptor& descriptor, const std::string& name, const Options& options,
+                  std::vector< Record >& records )
+{
+   const bool found = DispatchParityCount< kMaxCustomR >( descriptor, [&]( auto r ) {
+      HammingExtended< std::uint64_t, decltype( r )::value, 512 > code( descriptor );
+      BenchCode( code, name, options, records );
+   } );
+   if( !found )
+      std::cerr << name << ": R = " << descriptor.mH.Rows() << " is not supported\n";
+}
+
+void PrintText( const std::vector< Record >& records )
+{
+   std::printf( "%-15s %-8s %-4s %3s %6s %6s %4s %3s %3s %12s %10s %8s\n", "operation", "code", "T", "R", "N", "bytes",
+                "sys", "e", "ok", "ns/codeword", "MB/s", "allocs" );
+   for( const auto& r : records )
+      std::printf( "%-15s %-8s %-4s %3d %6d %6zu %4d %3d %3d %12.1f %10.1f %8.2f\n", r.mOperation.c_str(),
+                   r.mCode.c_str(), r.mType.c_str(), r.mR, r.mN, r.mSymbolBytes, r.mIsSystematic, r.mErasures,
+                   r.mIsOk, r.mNsPerCodeword, r.mMBps, r.mAllocsPerCall );
+}
+
+void PrintJson( const std::vector< Record >& records )
+{
+   std::printf( "{\n  \"xor_kernel\": \"%s\",\n  \"results\": [\n", SelectedXorKernel().mName );
+   for( std::size_t i = 0; i < records.size(); ++i )
+   {
+      const auto& r = records[ i ];
+      std::printf( "    {\"operation\": \"%s\", \"code\": \"%s\", \"type\": \"%s\", \"R\": %d, \"N\": %d, "
+                   "\"symbol_bytes\": %zu, \"systematic\": %s, \"erasures\": %d, \"ok\": %s, "
+                   "\"ns_per_codeword\": %.1f, \"mb_per_s\": %.1f, \"allocs_per_call\": %.3f}%s\n",
+                   r.mOperation.c_str(), r.mCode.c_str(), r.mType.c_str(), r.mR, r.mN, r.mSymbolBytes,
+                   r.mIsSystematic ? "true" : "false", r.mErasures, r.mIsOk ? "true" : "false", r.mNsPerCodeword,
+                   r.mMBps, r.mAllocsPerCall, i + 1 < records.size() ? "," : "" );
+   }
+   std::printf( "  ]\n}\n" );
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+   Options options;
+   for( int i = 1; i < argc; ++i )
+   {
+      if( std::strcmp( argv[ i ], "--json" ) == 0 )
+         options.mJson = true;
+      else if( std::strcmp( argv[ i ], "--min-ms" ) == 0 && i + 1 < argc )
+         options.mMinSeconds = std::stod( argv[ ++i ] ) * 1e-3;
+      else if( std::strcmp( argv[ i ], "--h" ) == 0 && i + 1 < argc )
+         options.mCustomPath = argv[ ++i ];
+      else
+      {
+         std::cerr << "Usage: " << argv[ 0 ] << " [--json] [--min-ms T] [--h matrices.txt]\n";
+         return 1;
+      }
+   }
+   std::vector< Record > records;
+   BenchType< std::uint8_t >( options, records );
+   BenchType< std::uint32_t >( options, records );
+   BenchType< std::uint64_t >( options, records );
+   if( !options.mCustomPath.empty() )
+   {
+      const auto descriptors = LoadTextCodeDescriptors( options.mCustomPath, 4 );
+      if( descriptors.empty() )
+         std::cerr << options.mCustomPath << ": no codes loaded\n";
+      for( std::size_t i = 0; i < descriptors.size(); ++i )
+         BenchCustom( descriptors[ i ], "custom" + std::to_string( i ), options, records );
+   }
+   if( options.mJson )
+      PrintJson( records );
+   else
+      PrintText( records );
+   return 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <cassert> // assert
+ #include <cstdint> // std::uint64_t
+ #include <bit>     // std::countr_zero, std::popcount
+ #include <utility> // std::swap
+ #include <vector>  // std::vector
+
+ namespace hamming
+ {
+
+ /**
+  * Двоичная матрица над GF(2). Строки упакованы в 64-битные слова,
+  * поэтому сложение строк выполняется сразу по 64 элемента.
+  * Все операции constexpr: матрицы можно строить на этапе компиляции.
+  */
+ struct BitMatrix
+ {
+    using Word = std::uint64_t;
+
+    static constexpr int kWordBits = 64;
+
+    constexpr BitMatrix() = default;
+
+    constexpr BitMatrix( int rows, int cols )
+       : mRows( rows ), mCols( cols ), mWords( ( cols + kWordBits - 1 ) / kWordBits ),
+         mData( static_cast< std::size_t >( rows ) * mWords, 0 )
+    {
+       assert( rows >= 0 && cols >= 0 );
+    }
+
+    /**
+     * Упаковать обычную матрицу (ненулевой элемент - единица).
+     */
+    template< typename T >
+    constexpr explicit BitMatrix( const std::vector< std::vector< T > >& M )
+       : BitMatrix( M.size(), M.empty() ? 0 : M.at( 0 ).size() )
+    {
+       for( int i = 0; i < mRows; ++i )
+       {
+          assert( std::cmp_equal( M.at( i ).size(), mCols ) );
+          for( int j = 0; j < mCols; ++j )
+             if( M[ i ][ j ] != 0 )
+                Set( i, j, true );
+       }
+    }
+
+    /**
+     * Распаковать в обычную матрицу (для вывода на экран и совместимости).
+     */
+    template< typename T = int >
+    constexpr std::vector< std::vector< T > > ToMatrix() const
+    {
+       std::vector< std::vector< T > > result( mRows, std::vector< T >( mCols, T( 0 ) ) );
+       for( int i = 0; i < mRows; ++i )
+          for( int j = 0; j < mCols; ++j )
+             result[ i ][ j ] = Get( i, j ) ? T( 1 ) : T( 0 );
+       return result;
+    }
+
+    /**
+     * Изменить размеры и обнулить матрицу. Память не перераспределяется, если ее достаточно.
+     */
+    constexpr void Reset( int rows, int cols )
+    {
+       assert( rows >= 0 && cols >= 0 );
+       mRows = rows;
+       mCols = cols;
+       mWords = ( cols + kWordBits - 1 ) / kWordBits;
+       mData.assign( static_cast< std::size_t >( rows ) * mWords, 0 );
+    }
+
+    constexpr int Rows() const { return mRows; }
+
+    constexpr int Cols() const { return mCols; }
+
+    /**
+     * Количество слов в одной строке.
+     */
+    constexpr int Words() const { return mWords; }
+
+    constexpr bool Empty() const { return mRows == 0; }
+
+    constexpr Word* Row( int i ) { return mData.data() + static_cast< std::size_t >( i ) * mWords; }
+
+    constexpr const Word* Row( int i ) const { return mData.data() + static_cast< std::size_t >( i ) * mWords; }
+
+    constexpr bool Get( int i, int j ) const
+    {
+       assert( i >= 0 && i < mRows && j >= 0 && j < mCols );
+       return ( Row( i )[ j / kWordBits ] >> ( j % kWordBits ) ) & 1;
+    }
+
+    constexpr void Set( int i, int j, bool value )
+    {
+       assert( i >= 0 && i < mRows && j >= 0 && j < mCols );
+       const Word mask = Word( 1 ) << ( j % kWordBits );
+       auto& word = Row( i )[ j / kWordBits ];
+       word = value ? ( word | mask ) : ( word & ~mask );
+    }
+
+    constexpr void Flip( int i, int j )
+    {
+       assert( i >= 0 && i < mRows && j >= 0 && j < mCols );
+       Row( i )[ j / kWordBits ] ^= Word( 1 ) << ( j % kWordBits );
+    }
+
+    /**
+     * Прибавить (XOR) строку src к строке dst.
+     */
+    constexpr void XorRow( int dst, int src )
+    {
+       assert( dst >= 0 && dst < mRows && src >= 0 && src < mRows );
+       Word* d = Row( dst );
+       const Word* s = Row( src );
+       for( int w = 0; w < mWords; ++w )
+          d[ w ] ^= s[ w ];
+    }
+
+    constexpr void SwapRows( int a, int b )
+    {
+       if( a == b )
+          return;
+       Word* ra = Row( a );
+       Word* rb = Row( b );
+       for( int w = 0; w < mWords; ++w )
+          std::swap( ra[ w ], rb[ w ] );
+    }
+
+    constexpr void SwapColumns( int a, int b )
+    {
+       if( a == b )
+          return;
+       for( int i = 0; i < mRows; ++i )
+       {
+          const bool x = Get( i, a );
+          const bool y = Get( i, b );
+          if( x != y )
+          {
+             Flip( i, a );
+             Flip( i, b );
+          }
+       }
+    }
+
+    /**
+     * Индекс первого ненулевого элемента строки i в диапазоне столбцов [from, to), либо -1.
+     */
+    constexpr int FindInRow( int i, int from, int to ) const
+    {
+       if( from >= to )
+          return -1;
+       const Word* r = Row( i );
+       int w = from / kWordBits;
+       Word word = r[ w ] & ( ~Word( 0 ) << ( from % kWordBits ) );
+       const int last = ( to - 1 ) / kWordBits;
+       for( ;; )
+       {
+          if( word != 0 )
+          {
+             const int j = w * kWordBits + std::countr_zero( word );
+             return j < to ? j : -1;
+          }
+          if( ++w > last )
+             return -1;
+          word = r[ w ];
+       }
+    }
+
+    /**
+     * Индекс первой строки, начиная с from, у которой в столбце j единица, либо -1.
+     */
+    constexpr int FindInColumn( int j, int from = 0 ) const
+    {
+       assert( j >= 0 && j < mCols );
+       const int w = j / kWordBits;
+       const Word mask = Word( 1 ) << ( j % kWordBits );
+       for( int i = from; i < mRows; ++i )
+          if( Row( i )[ w ] & mask )
+             return i;
+       return -1;
+    }
+
+    /**
+     * Вес (количество единиц) строки i.
+     */
+    constexpr int Weight( int i ) const
+    {
+       const Word* r = Row( i );
+       int weight = 0;
+       for( int w = 0; w < mWords; ++w )
+          weight += std::popcount( r[ w ] );
+       return weight;
+    }
+
+    constexpr bool operator==( const BitMatrix& other ) const = default;
+
+    int mRows = 0;
+
+    int mCols = 0;
+
+    int mWords = 0;
+
+    /**
+     * Строки подряд, по mWords слов на строку. Неиспользуемые старшие биты последнего слова равны нулю.
+     */
+    std::vector< Word > mData;
+ };
+
+ } // namespace hamming
@@ -0,0 +1,450 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <cctype>  // std::isdigit
+ #include <cstddef> // std::byte, std::size_t
+ #include <cstdint> // std::uint32_t, std::uint64_t
+ #include <cstring> // std::memcpy
+ #include <fstream> // std::ifstream, std::ofstream
+ #include <iterator> // std::istreambuf_iterator
+ #include <limits>  // std::numeric_limits
+ #include <sstream> // std::istringstream
+ #include <string>  // std::string
+ #include <type_traits> // std::integral_constant
+ #include <utility> // std::pair, std::integer_sequence
+ #include <vector>  // std::vector
+
+ #if defined( __unix__ ) || defined( __APPLE__ )
+ #define HAMMING_HAS_MMAP 1
+ #include <fcntl.h>    // open
+ #include <sys/mman.h> // mmap, munmap
+ #include <sys/stat.h> // fstat
+ #include <unistd.h>   // close
+ #else
+ #define HAMMING_HAS_MMAP 0
+ #endif
+
+ #include "bit_matrix.hpp"
+ #include "xor_schedule.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * Описание кода, достаточное для создания объекта кода без приведения H к систематическому виду:
+  * проверочные матрицы, перестановки столбцов, кодовое расстояние и (необязательно) расписание кодирования.
+  */
+ struct CodeDescriptor
+ {
+    BitMatrix mH;
+
+    BitMatrix mHsys;
+
+    std::vector< std::pair< int, int > > mSwaps;
+
+    int mD = 4;
+
+    /**
+     * Расписание XOR кодирования; пустое - строится при создании кода.
+     */
+    XorSchedule mEncodeSchedule;
+ };
+
+ /**
+  * Двоичный формат описания кода (порядок байт - платформы, в которой файл записан):
+  * заголовок kCodeDescriptorMagic, версия, признаки, R, N, D, количество перестановок, слов в строке;
+  * строки H и Hsys (64-битные слова); перестановки; расписание (если признак kHasSchedule);
+  * в конце - контрольная сумма FNV-1a 64 всех предыдущих байт.
+  */
+ inline constexpr std::uint32_t kCodeDescriptorMagic = 0x44435848; // "HXCD"
+
+ inline constexpr std::uint32_t kCodeDescriptorVersion = 1;
+
+ /**
+  * Проверка систематического вида: справа в Hsys единичная матрица R x R.
+  */
+ inline bool IsSystematicForm( const BitMatrix& Hsys )
+ {
+    const int R = Hsys.Rows();
+    const int N = Hsys.Cols();
+    for( int i = 0; i < R; ++i )
+       if( Hsys.FindInRow( i, N - R, N ) != N - R + i || Hsys.FindInRow( i, N - R + i + 1, N ) != -1 )
+          return false;
+    return true;
+ }
+
+ namespace detail
+ {
+
+ /**
+  * Равны ли нулю биты за столбцом N в последнем слове каждой строки (на этом основаны Weight и FindInRow).
+  */
+ inline bool HasZeroPadding( const BitMatrix& H )
+ {
+    const int tail = H.Cols() % BitMatrix::kWordBits;
+    if( tail == 0 )
+       return true;
+    const BitMatrix::Word padding = ~( ( BitMatrix::Word( 1 ) << tail ) - 1 );
+    for( int i = 0; i < H.Rows(); ++i )
+       if( H.Row( i )[ H.Words() - 1 ] & padding )
+          return false;
+    return true;
+ }
+
+ enum DescriptorFlags : std::uint32_t
+ {
+    kHasSchedule = 1
+ };
+
+ inline std::uint64_t Fnv1a64( const std::byte* data, std::size_t size )
+ {
+    std::uint64_t hash = 1469598103934665603ull;
+    for( std::size_t i = 0; i < size; ++i )
+    {
+       hash ^= std::to_integer< std::uint64_t >( data[ i ] );
+       hash *= 1099511628211ull;
+    }
+    return hash;
+ }
+
+ struct DescriptorWriter
+ {
+    template< typename U >
+    void Put( const U& value )
+    {
+       const auto* bytes = reinterpret_cast< const std::byte* >( &value );
+       mData.insert( mData.end(), bytes, bytes + sizeof( U ) );
+    }
+
+    template< typename U >
+    void Put( const std::vector< U >& values )
+    {
+       const auto* bytes = reinterpret_cast< const std::byte* >( values.data() );
+       mData.insert( mData.end(), bytes, bytes + values.size() * sizeof( U ) );
+    }
+
+    std::vector< std::byte > mData;
+ };
+
+ /**
+  * Чтение с проверкой границ: при выходе за конец буфера mIsOk становится false.
+  */
+ struct DescriptorReader
+ {
+    template< typename U >
+    bool Get( U& value )
+    {
+       return Get( &value, 1 );
+    }
+
+    template< typename U >
+    bool Get( U* values, std::size_t count )
+    {
+       const std::size_t bytes = count * sizeof( U );
+       if( !mIsOk || bytes > mSize - mOffset )
+          return mIsOk = false;
+       std::memcpy( values, mData + mOffset, bytes );
+       mOffset += bytes;
+       return true;
+    }
+
+    const std::byte* mData = nullptr;
+
+    std::size_t mSize = 0;
+
+    std::size_t mOffset = 0;
+
+    bool mIsOk = true;
+ };
+
+ inline bool ParseCodeDescriptor( const std::byte* data, std::size_t size, CodeDescriptor& descriptor )
+ {
+    if( size < sizeof( std::uint64_t ) )
+       return false;
+    std::uint64_t checksum;
+    std::memcpy( &checksum, data + size - sizeof( checksum ), sizeof( checksum ) );
+    if( checksum != Fnv1a64( data, size - sizeof( checksum ) ) )
+       return false;
+    DescriptorReader reader{ data, size - sizeof( checksum ) };
+    std::uint32_t magic = 0, version = 0, flags = 0, words = 0;
+    std::int32_t R = 0, N = 0, D = 0, swaps = 0;
+    reader.Get( magic );
+    reader.Get( version );
+    reader.Get( flags );
+    reader.Get( R );
+    reader.Get( N );
+    reader.Get( D );
+    reader.Get( swaps );
+    reader.Get( words );
+    if( !reader.mIsOk || magic != kCodeDescriptorMagic || version != kCodeDescriptorVersion || R <= 0 || N <= R ||
+        D <= 0 || D > R + 1 || swaps < 0 || std::cmp_not_equal( words, ( N + BitMatrix::kWordBits - 1 ) / BitMatrix::kWordBits ) ||
+        std::cmp_greater( 2 * static_cast< std::size_t >( R ) * words * sizeof( BitMatrix::Word ),
+                          reader.mSize - reader.mOffset ) )
+       return false;
+    descriptor.mD = D;
+    descriptor.mH = BitMatrix( R, N );
+    descriptor.mHsys = BitMatrix( R, N );
+    reader.Get( descriptor.mH.mData.data(), descriptor.mH.mData.size() );
+    reader.Get( descriptor.mHsys.mData.data(), descriptor.mHsys.mData.size() );
+    if( !HasZeroPadding( descriptor.mH ) || !HasZeroPadding( descriptor.mHsys ) || !IsSystematicForm( descriptor.mHsys ) )
+       return false;
+    // Количество перестановок ограничено длиной кода и остатком файла до выделения памяти.
+    if( swaps > N || std::cmp_greater( static_cast< std::size_t >( swaps ) * 2 * sizeof( std::int32_t ),
+                                       reader.mSize - reader.mOffset ) )
+       return false;
+    descriptor.mSwaps.resize( swaps );
+    for( auto& [a, b] : descriptor.mSwaps )
+    {
+       std::int32_t pair[ 2 ] = {};
+       reader.Get( pair, 2 );
+       a = pair[ 0 ];
+       b = pair[ 1 ];
+       if( a < 0 || a >= N || b < 0 || b >= N )
+          return false;
+    }
+    descriptor.mEncodeSchedule = {};
+    if( flags & kHasSchedule )
+    {
+       auto& schedule = descriptor.mEncodeSchedule;
+       std::int32_t inputs = 0, temps = 0, naive = 0, ops = 0, terms = 0, offsets = 0;
+       reader.Get( inputs );
+       reader.Get( temps );
+       reader.Get( naive );
+       reader.Get( ops );
+       reader.Get( terms );
+       reader.Get( offsets );
+       // Каждая промежуточная сумма - результат хотя бы одной операции: temps <= ops, и inputs + temps помещается в int.
+       if( !reader.mIsOk || inputs != N - R || temps < 0 || ops < 0 || temps > ops || terms < 0 || offsets != R + 1 ||
+           std::int64_t( inputs ) + temps > std::numeric_limits< std::int32_t >::max() ||
+           std::cmp_greater( ( static_cast< std::size_t >( ops ) * 3 + terms + offsets ) * sizeof( std::int32_t ),
+                             reader.mSize - reader.mOffset ) )
+          return false;
+       schedule.mInputs = inputs;
+       schedule.mTemps = temps;
+       schedule.mNaiveXors = naive;
+       schedule.mOps.resize( ops );
+       for( auto& op : schedule.mOps )
+       {
+          std::int32_t fields[ 3 ] = {};
+          reader.Get( fields, 3 );
+          op = { fields[ 0 ], fields[ 1 ], fields[ 2 ] };
+       }
+       schedule.mTerms.resize( terms );
+       reader.Get( schedule.mTerms.data(), schedule.mTerms.size() );
+       schedule.mOffsets.resize( offsets );
+       reader.Get( schedule.mOffsets.data(), schedule.mOffsets.size() );
+       const int variables = inputs + temps;
+       for( const auto& op : schedule.mOps )
+          if( op.mDst < inputs || op.mDst >= variables || op.mA < 0 || op.mA >= variables || op.mB < 0 ||
+              op.mB >= variables )
+             return false;
+       for( int term : schedule.mTerms )
+          if( term < 0 || term >= variables )
+             return false;
+       for( int i = 0; i < offsets; ++i )
+          if( schedule.mOffsets[ i ] < ( i ? schedule.mOffsets[ i - 1 ] : 0 ) || schedule.mOffsets[ i ] > terms )
+             return false;
+    }
+    return reader.mIsOk && reader.mOffset == reader.mSize;
+ }
+
+ } // namespace detail
+
+ /**
+  * Записать описание кода в двоичный файл. Возвращает false при ошибке записи.
+  * @param with_schedule - сохранить расписание кодирования (если оно не пустое).
+  */
+ inline bool SaveCodeDescriptor( const CodeDescriptor& descriptor, const std::string& path, bool with_schedule = true )
+ {
+    const auto& schedule = descriptor.mEncodeSchedule;
+    with_schedule &= !schedule.Empty();
+    detail::DescriptorWriter writer;
+    writer.Put( kCodeDescriptorMagic );
+    writer.Put( kCodeDescriptorVersion );
+    writer.Put( with_schedule ? std::uint32_t( detail::kHasSchedule ) : std::uint32_t( 0 ) );
+    writer.Put( std::int32_t( descriptor.mH.Rows() ) );
+    writer.Put( std::int32_t( descriptor.mH.Cols() ) );
+    writer.Put( std::int32_t( descriptor.mD ) );
+    writer.Put( std::int32_t( descriptor.mSwaps.size() ) );
+    writer.Put( std::uint32_t( descriptor.mH.Words() ) );
+    writer.Put( descriptor.mH.mData );
+    writer.Put( descriptor.mHsys.mData );
+    for( const auto& [a, b] : descriptor.mSwaps )
+    {
+       writer.Put( std::int32_t( a ) );
+       writer.Put( std::int32_t( b ) );
+    }
+    if( with_schedule )
+    {
+       writer.Put( std::int32_t( schedule.mInputs ) );
+       writer.Put( std::int32_t( schedule.mTemps ) );
+       writer.Put( std::int32_t( schedule.mNaiveXors ) );
+       writer.Put( std::int32_t( schedule.mOps.size() ) );
+       writer.Put( std::int32_t( schedule.mTerms.size() ) );
+       writer.Put( std::int32_t( schedule.mOffsets.size() ) );
+       for( const auto& op : schedule.mOps )
+       {
+          writer.Put( std::int32_t( op.mDst ) );
+          writer.Put( std::int32_t( op.mA ) );
+          writer.Put( std::int32_t( op.mB ) );
+       }
+       writer.Put( schedule.mTerms );
+       writer.Put( schedule.mOffsets );
+    }
+    writer.Put( detail::Fnv1a64( writer.mData.data(), writer.mData.size() ) );
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( reinterpret_cast< const char* >( writer.mData.data() ), writer.mData.size() );
+    return static_cast< bool >( file );
+ }
+
+ /**
+  * Прочитать описание кода из двоичного файла (отображением в память, где оно доступно).
+  * Возвращает false, если файл не читается, поврежден (контрольная сумма) или другой версии.
+  */
+ inline bool LoadCodeDescriptor( const std::string& path, CodeDescriptor& descriptor )
+ {
+ #if HAMMING_HAS_MMAP
+    const int fd = ::open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+       return false;
+    struct stat st;
+    if( ::fstat( fd, &st ) != 0 || st.st_size <= 0 )
+    {
+       ::close( fd );
+       return false;
+    }
+    const std::size_t size = st.st_size;
+    void* mapped = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if( mapped == MAP_FAILED )
+       return false;
+    const bool is_ok = detail::ParseCodeDescriptor( static_cast< const std::byte* >( mapped ), size, descriptor );
+    ::munmap( mapped, size );
+    return is_ok;
+ #else
+    std::ifstream file( path, std::ios::binary );
+    std::vector< char > data( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+    return !data.empty() &&
+           detail::ParseCodeDescriptor( reinterpret_cast< const std::byte* >( data.data() ), data.size(), descriptor );
+ #endif
+ }
+
+ /**
+  * Прочитать описания кодов из текстового файла формата example_ldpc_small.txt: для каждого кода секции
+  * "H:" и "Systematic form of H:" (строки из 0 и 1 через запятую) и "Swaps:" (пары "(a: b)").
+  * Прочие строки (например, "US:", "Threshold ...") пропускаются. Коды без секции "Systematic form of H:",
+  * с неверными размерами или без единичной матрицы справа в Hsys пропускаются.
+  * @param code_distance - кодовое расстояние кодов (в файле не задается).
+  */
+ inline std::vector< CodeDescriptor > LoadTextCodeDescriptors( const std::string& path, int code_distance )
+ {
+    std::vector< CodeDescriptor > result;
+    std::ifstream file( path );
+    std::vector< std::vector< int > > H, Hsys;
+    std::vector< std::pair< int, int > > swaps;
+    std::vector< std::vector< int > >* matrix = nullptr;
+    bool in_swaps = false;
+    auto to_bits = []( const std::vector< std::vector< int > >& rows, BitMatrix& bits ) {
+       if( rows.empty() )
+          return false;
+       for( const auto& row : rows )
+          if( row.size() != rows.front().size() )
+             return false;
+       bits = BitMatrix( rows );
+       return true;
+    };
+    auto flush = [&]() {
+       CodeDescriptor descriptor;
+       descriptor.mD = code_distance;
+       descriptor.mSwaps = swaps;
+       if( to_bits( H, descriptor.mH ) && to_bits( Hsys, descriptor.mHsys ) &&
+           descriptor.mH.Rows() == descriptor.mHsys.Rows() && descriptor.mH.Cols() == descriptor.mHsys.Cols() &&
+           descriptor.mH.Cols() > descriptor.mH.Rows() && IsSystematicForm( descriptor.mHsys ) )
+          result.push_back( std::move( descriptor ) );
+       H.clear();
+       Hsys.clear();
+       swaps.clear();
+       matrix = nullptr;
+       in_swaps = false;
+    };
+    std::string line;
+    while( std::getline( file, line ) )
+    {
+       if( line.rfind( "H:", 0 ) == 0 )
+       {
+          if( !H.empty() )
+             flush();
+          matrix = &H;
+          in_swaps = false;
+          continue;
+       }
+       if( line.rfind( "Systematic form of H:", 0 ) == 0 )
+       {
+          matrix = &Hsys;
+          in_swaps = false;
+          continue;
+       }
+       if( line.rfind( "Swaps:", 0 ) == 0 )
+       {
+          matrix = nullptr;
+          in_swaps = true;
+          continue;
+       }
+       if( in_swaps && line.find( '(' ) != std::string::npos )
+       {
+          for( std::size_t pos = line.find( '(' ); pos != std::string::npos; pos = line.find( '(', pos + 1 ) )
+          {
+             int a = 0, b = 0;
+             char colon = 0;
+             std::istringstream pair( line.substr( pos + 1 ) );
+             if( pair >> a >> colon >> b && colon == ':' )
+                swaps.emplace_back( a, b );
+          }
+          continue;
+       }
+       if( matrix && !line.empty() && std::isdigit( static_cast< unsigned char >( line.front() ) ) )
+       {
+          std::vector< int > row;
+          std::istringstream values( line );
+          std::string value;
+          while( std::getline( values, value, ',' ) )
+             if( value.find_first_not_of( ' ' ) != std::string::npos )
+                row.push_back( std::stoi( value ) );
+          matrix->push_back( std::move( row ) );
+          continue;
+       }
+       matrix = nullptr;
+       in_swaps = false;
+    }
+    if( !H.empty() )
+       flush();
+    return result;
+ }
+
+ namespace detail
+ {
+
+ template< int... Rs, typename Function >
+ bool DispatchParityCount( int R, Function& function, std::integer_sequence< int, Rs... > )
+ {
+    return ( ... || ( R == Rs + 3 && ( function( std::integral_constant< int, Rs + 3 >{} ), true ) ) );
+ }
+
+ } // namespace detail
+
+ /**
+  * Коды с внешней матрицей: R известно только во время выполнения, поэтому выбирается из диапазона 3..MaxR.
+  * Вызывает function( std::integral_constant< int, R >{} ) для R = descriptor.mH.Rows(), например, чтобы
+  * создать HammingExtended< T, R, M >( descriptor ). Возвращает false, если R вне диапазона.
+  */
+ template< int MaxR, typename Function >
+ bool DispatchParityCount( const CodeDescriptor& descriptor, Function&& function )
+ {
+    static_assert( MaxR >= 3 );
+    return detail::DispatchParityCount( descriptor.mH.Rows(), function, std::make_integer_sequence< int, MaxR - 2 >{} );
+ }
+
+ } // namespace hamming
@@ -0,0 +1,351 @@
+/**
+ * Исследование восстановимости методом Монте-Карло.
+ * Для каждой кратности стирания e выбираются случайные наборы стертых символов; восстановимость
+ * проверяется без данных (RecoverableMask: приведение столбцов к базису в 64-битных словах), а на подвыборке измеряется
+ * задержка реального декодирования DecodeSymbols с рабочей областью и сверяется его результат.
+ * Запуск: explore [--json] [--patterns P] [--latency L] [--threads n] [--seed s] [--target p] [--h file.txt]
+ */
+
+#include <algorithm> // std::sort
+#include <chrono>    // std::chrono
+#include <cstdio>    // std::printf
+#include <cstring>   // std::strcmp
+#include <iostream>  // std::cerr
+#include <numeric>   // std::iota
+#include <random>    // std::mt19937
+#include <string>    // std::string
+#include <utility>   // std::swap
+#include <vector>    // std::vector
+
+#include "hamming.hpp"
+
+namespace
+{
+
+using namespace hamming;
+
+struct Options
+{
+   bool mJson = false;
+
+   std::size_t mPatterns = 1'000'000;
+
+   std::size_t mLatencySamples = 10'000;
+
+   unsigned mThreads = std::thread::hardware_concurrency();
+
+   std::uint64_t mSeed = 1;
+
+   double mTarget = 0.999;
+
+   std::string mCustomPath;
+};
+
+/**
+ * Результат для одной кратности стирания.
+ */
+struct Record
+{
+   std::string mCode;
+
+   int mR = 0;
+
+   int mN = 0;
+
+   int mErasures = 0;
+
+   std::size_t mPatterns = 0;
+
+   /**
+    * Decode вернул бы true: восстановлены все стертые информационные символы.
+    */
+   std::size_t mDecodable = 0;
+
+   /**
+    * Восстановимы все стертые символы, включая проверочные.
+    */
+   std::size_t mFullyRecoverable = 0;
+
+   double mPatternsPerSecond = 0;
+
+   std::size_t mLatencySamples = 0;
+
+   /**
+    * Расхождения результата DecodeSymbols с проверкой без данных (должно быть 0).
+    */
+   std::size_t mMismatches = 0;
+
+   double mP50 = 0;
+
+   double mP90 = 0;
+
+   double mP99 = 0;
+
+   double mP999 = 0;
+
+   double mMax = 0;
+};
+
+/**
+ * Количество порций выборки: не зависит от числа потоков, поэтому результат воспроизводим при заданном seed.
+ */
+constexpr std::size_t kBlocks = 256;
+
+/**
+ * Выбрать e различных индексов из [0, N): частичная перестановка Фишера-Йетса по месту.
+ * Массив остается перестановкой, поэтому восстанавливать его между вызовами не нужно.
+ * Случайный индекс в [0, n) - старшие 32 бита произведения gen() * n, без деления.
+ */
+std::span< const int > SampleErasures( std::vector< int >& indices, int e, std::mt19937& gen )
+{
+   const int N = indices.size();
+   for( int t = 0; t < e; ++t )
+      std::swap( indices[ t ], indices[ t + ( ( std::uint64_t( gen() ) * ( N - t ) ) >> 32 ) ] );
+   return std::span< const int >( indices ).first( e );
+}
+
+/**
+ * Генератор порции: зависит от seed, кода, кратности, номера порции и вида выборки (0 - без данных, 1 - задержка).
+ */
+std::mt19937 MakeGenerator( std::uint64_t seed, int R, int e, std::size_t block, int stream )
+{
+   std::seed_seq sequence{ std::uint32_t( seed ), std::uint32_t( seed >> 32 ), std::uint32_t( R ), std::uint32_t( e ),
+                           std::uint32_t( block ), std::uint32_t( stream ) };
+   return std::mt19937( sequence );
+}
+
+double Percentile( const std::vector< double >& sorted, double q )
+{
+   if( sorted.empty() )
+      return 0;
+   return sorted[ std::min( sorted.size() - 1, static_cast< std::size_t >( q * sorted.size() ) ) ];
+}
+
+template< int R, int M >
+void ExploreCode( const HammingExtended< std::uint64_t, R, M >& code, const std::string& name,
+                  const Options& options, ThreadPool& pool, std::vector< Record >& records )
+{
+   constexpr std::size_t bytes = sizeof( std::uint64_t ) * M;
+   for( int e = 1; e <= R; ++e )
+   {
+      Record record;
+      record.mCode = name;
+      record.mR = R;
+      record.mN = code.N;
+      record.mErasures = e;
+      record.mPatterns = options.mPatterns;
+
+      // Проверка без данных.
+      std::vector< std::size_t > decodable( kBlocks ), fully( kBlocks );
+      const auto start = std::chrono::steady_clock::now();
+      pool.ParallelFor( kBlocks, [&]( std::size_t block ) {
+         auto gen = MakeGenerator( options.mSeed, R, e, block, 0 );
+         std::vector< int > indices( code.N );
+         std::iota( indices.begin(), indices.end(), 0 );
+         const std::size_t count = options.mPatterns / kBlocks + ( block < options.mPatterns % kBlocks );
+         const std::uint64_t all_erased = ~std::uint64_t( 0 ) >> ( 64 - e );
+         std::size_t ok = 0, all = 0;
+         for( std::size_t i = 0; i < count; ++i )
+         {
+            const auto ids = SampleErasures( indices, e, gen );
+            const std::uint64_t recoverable = code.RecoverableMask( ids );
+            std::uint64_t info = 0;
+            for( int k = 0; k < e; ++k )
+               info |= std::uint64_t( ids[ k ] < code.K ) << k;
+            ok += ( recoverable & info ) == info;
+            all += recoverable == all_erased;
+         }
+         decodable[ block ] = ok;
+         fully[ block ] = all;
+      } );
+      const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+      for( std::size_t block = 0; block < kBlocks; ++block )
+      {
+         record.mDecodable += decodable[ block ];
+         record.mFullyRecoverable += fully[ block ];
+      }
+      record.mPatternsPerSecond = options.mPatterns / elapsed.count();
+
+      // Задержка декодирования на подвыборке; у каждой порции свои буферы и рабочая область.
+      std::vector< std::vector< double > > latencies( kBlocks );
+      std::vector< std::size_t > mismatches( kBlocks );
+      pool.ParallelFor( kBlocks, [&]( std::size_t block ) {
+         auto gen = MakeGenerator( options.mSeed, R, e, block, 1 );
+         std::vector< int > indices( code.N );
+         std::iota( indices.begin(), indices.end(), 0 );
+         std::vector< std::uint64_t > data( code.N * M );
+         for( auto& x : data )
+            x = gen();
+         std::vector< std::byte* > symbols( code.N );
+         for( int j = 0; j < code.N; ++j )
+            symbols[ j ] = reinterpret_cast< std::byte* >( data.data() + j * M );
+         std::vector< std::uint64_t > erasures( ( code.N + 63 ) / 64 );
+         auto workspace = code.MakeWorkspace();
+         const std::size_t count = options.mLatencySamples / kBlocks + ( block < options.mLatencySamples % kBlocks );
+         latencies[ block ].reserve( count );
+         for( std::size_t i = 0; i < count; ++i )
+         {
+            const auto ids = SampleErasures( indices, e, gen );
+            std::fill( erasures.begin(), erasures.end(), 0 );
+            for( int id : ids )
+            {
+               const int p = code.Position( id );
+               erasures[ p / 64 ] |= std::uint64_t( 1 ) << ( p % 64 );
+            }
+            int erased;
+            const auto t0 = std::chrono::steady_clock::now();
+            const bool is_ok = code.DecodeSymbols( symbols, erasures, bytes, erased, workspace );
+            const auto t1 = std::chrono::steady_clock::now();
+            latencies[ block ].push_back( std::chrono::duration< double, std::nano >( t1 - t0 ).count() );
+            mismatches[ block ] += is_ok != code.IsDecodable( ids );
+         }
+      } );
+      std::vector< double > all;
+      for( std::size_t block = 0; block < kBlocks; ++block )
+      {
+         all.insert( all.end(), latencies[ block ].begin(), latencies[ block ].end() );
+         record.mMismatches += mismatches[ block ];
+      }
+      std::sort( all.begin(), all.end() );
+      record.mLatencySamples = all.size();
+      record.mP50 = Percentile( all, 0.5 );
+      record.mP90 = Percentile( all, 0.9 );
+      record.mP99 = Percentile( all, 0.99 );
+      record.mP999 = Percentile( all, 0.999 );
+      record.mMax = all.empty() ? 0 : all.back();
+      records.push_back( record );
+   }
+}
+
+template< int R >
+void ExploreBuiltin( const Options& options, ThreadPool& pool, std::vector< Record >& records )
+{
+   HammingExtended< std::uint64_t, R, 8 > code;
+   ExploreCode( code, "builtin", options, pool, records );
+}
+
+/**
+ * Наибольшее R кода с внешней матрицей (см. DispatchParityCount).
+ */
+constexpr int kMaxCustomR = 32;
+
+void ExploreCustom( const CodeDescriptor& descriptor, const std::string& name, const Options& options,
+                    ThreadPool& pool, std::vector< Record >& records )
+{
+   const bool found = DispatchParityCount< kMaxCustomR >( descriptor, [&]( auto r ) {
+      HammingExtended< std::uint64_t, decltype( r )::value, 8 > code( descriptor );
+      ExploreCode( code, name, options, pool, records );
+   } );
+   if( !found )
+      std::cerr << name << ": R = " << descriptor.mH.Rows() << " is not supported\n";
+}
+
+/**
+ * Порог: наибольшая кратность e, до которой включительно вероятность восстановления не ниже target.
+ */
+int Threshold( const std::vector< Record >& records, std::size_t first, std::size_t last, double target )
+{
+   int threshold = 0;
+   for( std::size_t i = first; i < last; ++i )
+   {
+      if( double( records[ i ].mDecodable ) < target * records[ i ].mPatterns )
+         break;
+      threshold = records[ i ].mErasures;
+   }
+   return threshold;
+}
+
+void PrintText( const std::vector< Record >& records, const Options& options )
+{
+   std::printf( "%-8s %3s %5s %3s %10s %10s %10s %11s %9s %9s %9s %9s %9s\n", "code", "R", "N", "e", "patterns",
+                "P(decode)", "P(all)", "patterns/s", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "mismatch" );
+   for( std::size_t first = 0, i = 0; i < records.size(); ++i )
+   {
+      const auto& r = records[ i ];
+      std::printf( "%-8s %3d %5d %3d %10zu %10.6f %10.6f %11.3g %9.0f %9.0f %9.0f %9.0f %9zu\n", r.mCode.c_str(),
+                   r.mR, r.mN, r.mErasures, r.mPatterns, double( r.mDecodable ) / r.mPatterns,
+                   double( r.mFullyRecoverable ) / r.mPatterns, r.mPatternsPerSecond, r.mP50, r.mP90, r.mP99, r.mP999,
+                   r.mMismatches );
+      if( i + 1 == records.size() || records[ i + 1 ].mErasures == 1 )
+      {
+         std::printf( "%-8s threshold (P >= %g): e <= %d\n\n", r.mCode.c_str(), options.mTarget,
+                      Threshold( records, first, i + 1, options.mTarget ) );
+         first = i + 1;
+      }
+   }
+}
+
+void PrintJson( const std::vector< Record >& records, const Options& options )
+{
+   std::printf( "{\n  \"seed\": %llu,\n  \"target\": %g,\n  \"results\": [\n",
+                static_cast< unsigned long long >( options.mSeed ), options.mTarget );
+   for( std::size_t i = 0; i < records.size(); ++i )
+   {
+      const auto& r = records[ i ];
+      std::printf( "    {\"code\": \"%s\", \"R\": %d, \"N\": %d, \"erasures\": %d, \"patterns\": %zu, "
+                   "\"decodable\": %zu, \"fully_recoverable\": %zu, \"p_decode\": %.9f, \"patterns_per_s\": %.1f, "
+                   "\"latency_samples\": %zu, \"mismatches\": %zu, \"latency_ns\": {\"p50\": %.1f, \"p90\": %.1f, "
+                   "\"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}}%s\n",
+                   r.mCode.c_str(), r.mR, r.mN, r.mErasures, r.mPatterns, r.mDecodable, r.mFullyRecoverable,
+                   double( r.mDecodable ) / r.mPatterns, r.mPatternsPerSecond, r.mLatencySamples, r.mMismatches,
+                   r.mP50, r.mP90, r.mP99, r.mP999, r.mMax, i + 1 < records.size() ? "," : "" );
+   }
+   std::printf( "  ]\n}\n" );
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+   Options options;
+   for( int i = 1; i < argc; ++i )
+   {
+      if( std::strcmp( argv[ i ], "--json" ) == 0 )
+         options.mJson = true;
+      else if( std::strcmp( argv[ i ], "--patterns" ) == 0 && i + 1 < argc )
+         options.mPatterns = std::stoull( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--latency" ) == 0 && i + 1 < argc )
+         options.mLatencySamples = std::stoull( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc )
+         options.mThreads = std::stoul( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--seed" ) == 0 && i + 1 < argc )
+         options.mSeed = std::stoull( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--target" ) == 0 && i + 1 < argc )
+         options.mTarget = std::stod( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--h" ) == 0 && i + 1 < argc )
+         options.mCustomPath = argv[ ++i ];
+      else
+      {
+         std::cerr << "Usage: " << argv[ 0 ]
+                   << " [--json] [--patterns P] [--latency L] [--threads n] [--seed s] [--target p] [--h file.txt]\n";
+         return 1;
+      }
+   }
+   if( options.mPatterns == 0 )
+   {
+      std::cerr << "--patterns must be positive\n";
+      return 1;
+   }
+   ThreadPool pool( options.mThreads );
+   std::vector< Record > records;
+   if( options.mCustomPath.empty() )
+   {
+      ExploreBuiltin< 4 >( options, pool, records );
+      ExploreBuiltin< 6 >( options, pool, records );
+      ExploreBuiltin< 8 >( options, pool, records );
+      ExploreBuiltin< 10 >( options, pool, records );
+   }
+   else
+   {
+      const auto descriptors = LoadTextCodeDescriptors( options.mCustomPath, 4 );
+      if( descriptors.empty() )
+         std::cerr << options.mCustomPath << ": no codes loaded\n";
+      for( std::size_t i = 0; i < descriptors.size(); ++i )
+         ExploreCustom( descriptors[ i ], "custom" + std::to_string( i ), options, pool, records );
+   }
+   if( options.mJson )
+      PrintJson( records, options );
+   else
+      PrintText( records, options );
+   return 0;
+}
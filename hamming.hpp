@@ -11,6 +11,20 @@
  #include <array>    // std::array
  #include <vector>   // std::vector
  #include <string>   // std::string
+ #include <memory>   // std::shared_ptr
+ #include <optional> // std::optional
+ #include <span>     // std::span
+ #include <cstring>  // std::memcpy
+ #include <cstdint>  // std::uint64_t
+ #include <algorithm> // std::copy, std::lower_bound, std::sort
+ #include <bit>      // std::countr_zero, std::popcount
+
+ #include "bit_matrix.hpp"
+ #include "code_descriptor.hpp"
+ #include "recovery.hpp"
+ #include "thread_pool.hpp"
+ #include "xor_kernels.hpp"
+ #include "xor_schedule.hpp"
  
  namespace hamming
  {
@@ -34,6 +48,10 @@
     }
     std::cout << std::flush;
  }
+
+ inline void show_matrix(const BitMatrix& M, const std::string& title) {
+    show_matrix(M.ToMatrix(), title);
+ }
  
  /**
   * Статус принятого (канального) символа.
@@ -81,6 +99,18 @@
           return { SymbolStatus::Erased, {} }; // x + x = x.
       return { SymbolStatus::Uninitialized, {} }; 
     }
+
+    /**
+     * Сложение по месту, без временных объектов. Семантика стираний та же, что у operator+.
+     */
+    CodeElement& operator+=( const CodeElement& other )
+    {
+       if( ( mStatus == SymbolStatus::Normal ) && ( other.mStatus == SymbolStatus::Normal ) )
+          XorInto( mSymbol.data(), other.mSymbol.data(), sizeof( mSymbol ) );
+       else
+          *this = *this + other;
+       return *this;
+    }
  
     /**
      * 
@@ -98,21 +128,18 @@
   * Формирует лидирующие элементы, используя взвешенную сумму.
   * Таким образом у проверочной матрицы справа формируется единичная матрица.
   */
- template< typename T >
- inline bool FormLeadBySum( int i, Matrix< T >& H, int column_idx = -1 )
+ constexpr bool FormLeadBySum( int i, BitMatrix& H, int column_idx = -1 )
  {
-    assert(!H.empty());
-    int R = H.size();
-    int N = H.at( 0 ).size();
+    assert(!H.Empty());
+    const int R = H.Rows();
+    const int N = H.Cols();
     const int column = column_idx == -1 ? N - R + i : column_idx;
-    auto main_element = H.at( i ).at( column );
-    if( main_element != 0 )
+    if( H.Get( i, column ) )
        return true;
     int idx = -1;
     for( int j = i - 1; j >= 0; --j )
     {
-       auto element = H.at( j ).at( column );
-       if( element != 0 )
+       if( H.Get( j, column ) )
        {
           idx = j;
           break;
@@ -122,10 +149,7 @@
     {
        return false;
     }
-    for( int k = 0; k < N; ++k )
-    {
-       H[ i ][ k ] ^= H.at( idx ).at( k );
-    }
+    H.XorRow( i, idx );
     return true;
  }
  
@@ -133,42 +157,29 @@
   * Формирует лидирующие элементы, используя перестановки столбцов (swap).
   * Таким образом у проверочной матрицы справа формируется единичная матрица.
   */
- template< typename T >
- inline std::pair<bool, std::pair<int, int>> FormLeadBySwap( int i, Matrix< T >& H, int column_idx = -1, const std::vector< int >& columns = {} )
+ constexpr std::pair<bool, std::pair<int, int>> FormLeadBySwap( int i, BitMatrix& H, int column_idx = -1, const std::vector< int >& columns = {} )
  {
-   assert(!H.empty());
-    int R = H.size();
-    int N = H.at( 0 ).size();
+   assert(!H.Empty());
+    const int R = H.Rows();
+    const int N = H.Cols();
     const int column = column_idx == -1 ? N - R + i : column_idx;
-    auto main_element = H.at( i ).at( column );
-    if( main_element != 0 )
+    if( H.Get( i, column ) )
        return std::make_pair(true, std::make_pair(-1, -1));
     int idx = -1;
     if( columns.size() == 0 )
     {
-       for( int j = 0; j < N - R; ++j )
-       {
-          auto element = H.at( i ).at( j );
-          if( element != 0 )
-          {
-             idx = j;
-             break;
-          }
-       }
+       idx = H.FindInRow( i, 0, N - R );
     }
     else
     {
-       for( int j = 0; j < N; ++j )
+       for( int j = H.FindInRow( i, 0, N ); j != -1; j = H.FindInRow( i, j + 1, N ) )
        {
           bool has = false;
           for( auto el : columns )
           {
              has |= el == j;
           }
-          if( has )
-             continue;
-          auto element = H.at( i ).at( j );
-          if( element != 0 )
+          if( !has )
           {
              idx = j;
              break;
@@ -179,10 +190,7 @@
     {
        return std::make_pair(false, std::make_pair(-1, -1));
     }
-    for( int j = 0; j < R; ++j )
-    {
-       std::swap( H[ j ][ column ], H[ j ][ idx ] );
-    }
+    H.SwapColumns( column, idx );
     return std::make_pair(true, std::make_pair(column, idx));
  }
 
@@ -190,19 +198,18 @@
   * Формирует систематическую проверочную матрицу по несистематической.
   * @param columns Столбцы, которые будут базисными (по умочанию - справа).
   */
- template< typename T >
- inline std::pair<Matrix< T >, Swaps<T>> MakeParityMatrixSystematic( const Matrix< T >& H, bool& is_ok,
-                                                const std::vector< int >& columns = {} )
+ constexpr std::pair<BitMatrix, Swaps<int>> MakeParityMatrixSystematic( const BitMatrix& H, bool& is_ok,
+                                                   const std::vector< int >& columns = {} )
  {
     is_ok = true; // Признак успешности преобразования.
-    const int R = H.size();
-    const int N = H.empty() ? 0 : H.at( 0 ).size();
+    const int R = H.Rows();
+    const int N = H.Cols();
     auto result = H;
-    Swaps<T> swaps;
-    if (H.empty()) {
+    Swaps<int> swaps;
+    if (H.Empty()) {
       return std::make_pair(result, swaps);
     }
-    std::pair<T, T> swaped_indexes;
+    std::pair<int, int> swaped_indexes;
     // Формирование верхней треугольной матрицы (справа).
     for( int i = R - 1; i >= 0; --i )
     {
@@ -216,10 +223,8 @@
        for( int j = i - 1; j >= 0; --j )
        {
           int idx = std::cmp_not_equal(columns.size(), R) ? N + i - R : columns.at( i );
-          if( auto reference = result.at( j ).at( idx ); reference == 0 )
-             continue;
-          for( int k = 0; k < N; ++k )
-             result[ j ][ k ] ^= result[ i ][ k ];
+          if( result.Get( j, idx ) )
+             result.XorRow( j, i );
        }
     }
     // Формирование нижней треугольной матрицы (справа).
@@ -228,56 +233,58 @@
        for( int j = i + 1; j < R; ++j )
        {
           int idx = std::cmp_not_equal(columns.size(), R) ? N + i - R : columns.at( i );
-          if( auto reference = result.at( j ).at( idx ); reference == 0 )
-             continue;
-          for( int k = 0; k < N; ++k )
-             result[ j ][ k ] ^= result[ i ][ k ];
+          if( result.Get( j, idx ) )
+             result.XorRow( j, i );
        }
     }
     return std::make_pair(result, swaps);
  }
 
+ /**
+  * Формирует систематическую проверочную матрицу по несистематической (обычный формат матрицы).
+  * @param columns Столбцы, которые будут базисными (по умочанию - справа).
+  */
+ template< typename T >
+ inline std::pair<Matrix< T >, Swaps<T>> MakeParityMatrixSystematic( const Matrix< T >& H, bool& is_ok,
+                                                const std::vector< int >& columns = {} )
+ {
+    const auto& [bits, swaps] = MakeParityMatrixSystematic( BitMatrix( H ), is_ok, columns );
+    Swaps<T> result_swaps;
+    for (const auto& [a, b] : swaps) {
+       result_swaps.emplace_back(a, b);
+    }
+    return std::make_pair(bits.template ToMatrix<T>(), result_swaps);
+ }
+
  /**
   * Подготавливает методом Гаусса матрицу и столбец свободных членов к решению обратным ходом.
   * @param free_column - столбец свободных членов, dim(free_column) = (r x 1).
   * @param selected - прямоугольная матрица, dim(selected) = (r x e).
-  * Сложность O(r * e^2).
+  * Сложность O(r * e^2 / 64).
   */
  template< typename T, int M >
- void Gauss(CodeWord<T, M>& free_column, Matrix<int>& selected) {
+ void Gauss(CodeWord<T, M>& free_column, BitMatrix& selected) {
    const int R = free_column.size();
    assert(R > 0);
-   assert(!selected.empty());
-   const int erased = selected.at(0).size();
+   assert(!selected.Empty());
+   const int erased = selected.Cols();
    assert(erased > 0);
    for( int k = 0; k < erased; ++k ) {
-      int where_unit = -1;
-      for( int i = k; i < R; ++i ) {
-         const bool is_not_zero = (selected.at(i).at(k) != 0);
-         if (is_not_zero) {
-            where_unit = i;
-            break;
-         }
-      }
+      const int where_unit = selected.FindInColumn(k, k);
       if (where_unit == -1)
          continue;
       if (where_unit > k) {
          free_column[ k ] = free_column.at(k) + free_column.at( where_unit );
-         for( int k1 = 0; k1 < erased; ++k1 ) {
-            selected[k][k1] ^= selected.at( where_unit ).at( k1 );
-         }
+         selected.XorRow(k, where_unit);
       }
       // Обнуляем до конца: при этом метод гарантированно за один проход выдает разрешимую 
       // матрицу (если исходная СЛАУ имеет решение).
       // Матрица разрешимая - значит все элементы главной диагонали квадратной подматрицы ненулевые.
       // При такой стратегии все элементы ниже квадратной подматрицы равны нулю.
       for( int i = k + 1; i < R; ++i ) {
-         const bool is_not_zero = (selected.at(i).at(k) != 0);
-         if (is_not_zero) {
+         if (selected.Get(i, k)) {
             free_column[ i ] = free_column.at(i) + free_column.at( k );
-            for( int k1 = 0; k1 < erased; ++k1 ) {
-               selected[i][k1] ^= selected.at( k ).at( k1 );
-            }
+            selected.XorRow(i, k);
          }
       }
    }
@@ -288,7 +295,184 @@
  {
     return (x > 0) ? (T( 1 ) << x) : T(1);
  }
- 
+
+ /**
+  * Несистематическая проверочная матрица встроенного расширенного кода Хэмминга, dim = (R x 2^(R-1)):
+  * первая строка из единиц, остальные - двоичные разряды номера столбца (j + 1).
+  */
+ constexpr BitMatrix MakeExtendedHammingMatrix( int R )
+ {
+    const int N = power2<int>( R - 1 );
+    BitMatrix H( R, N );
+    for( int j = 0; j < N; ++j )
+       H.Set( 0, j, true );
+    int deg = N / 2;
+    for( int i = 1; i < R; ++i )
+    {
+       for( int j = 0; j < N; ++j )
+          H.Set( i, j, ( ( ( j + 1 ) / deg ) % 2 ) == 1 );
+       deg /= 2;
+    }
+    return H;
+ }
+
+ /**
+  * Наибольшее R, для которого матрицы встроенного кода и расписание кодирования строятся на этапе компиляции.
+  */
+ inline constexpr int kMaxStaticR = 8;
+
+ /**
+  * Таблицы встроенного расширенного кода Хэмминга, вычисленные на этапе компиляции.
+  */
+ template< int R >
+ struct ExtendedHammingTables
+ {
+    static constexpr int N = power2<int>( R - 1 );
+
+    static constexpr int K = N - R;
+
+    static constexpr int W = ( N + BitMatrix::kWordBits - 1 ) / BitMatrix::kWordBits;
+
+    using Rows = std::array< std::array< BitMatrix::Word, W >, R >;
+
+    Rows mH{};
+
+    Rows mHsys{};
+
+    std::array< std::pair< int, int >, R > mSwaps{};
+
+    int mSwapCount = 0;
+
+    /**
+     * Количество единиц в информационной части Hsys (длина расписания кодирования).
+     */
+    int mWeight = 0;
+
+    /**
+     * Количество проверочных строк без единиц в информационной части.
+     */
+    int mEmptyRows = 0;
+
+    bool mIsOk = false;
+ };
+
+ template< int R >
+ constexpr ExtendedHammingTables< R > MakeExtendedHammingTables()
+ {
+    using Tables = ExtendedHammingTables< R >;
+    Tables tables;
+    const auto H = MakeExtendedHammingMatrix( R );
+    const auto [Hsys, swaps] = MakeParityMatrixSystematic( H, tables.mIsOk );
+    for( int i = 0; i < R; ++i )
+    {
+       for( int w = 0; w < Tables::W; ++w )
+       {
+          tables.mH[ i ][ w ] = H.Row( i )[ w ];
+          tables.mHsys[ i ][ w ] = Hsys.Row( i )[ w ];
+       }
+       // Справа в Hsys единичная матрица: в информационной части на одну единицу меньше.
+       const int weight = Hsys.Weight( i ) - 1;
+       tables.mWeight += weight;
+       tables.mEmptyRows += weight == 0;
+    }
+    for( const auto& swap : swaps )
+       tables.mSwaps[ tables.mSwapCount++ ] = swap;
+    return tables;
+ }
+
+ template< int R >
+ inline constexpr auto kExtendedHammingTables = MakeExtendedHammingTables< R >();
+
+ /**
+  * Операция расписания кодирования: symbols[mDst] = symbols[mSrc] (первое слагаемое) либо symbols[mDst] ^= symbols[mSrc].
+  * mSrc == -1 - обнулить symbols[mDst] (проверочный символ без слагаемых).
+  */
+ struct EncodeOp
+ {
+    int mDst = 0;
+
+    int mSrc = 0;
+
+    bool mIsFirst = false;
+ };
+
+ template< int R >
+ constexpr auto MakeExtendedHammingEncodeOps()
+ {
+    using Tables = ExtendedHammingTables< R >;
+    constexpr auto& tables = kExtendedHammingTables< R >;
+    std::array< EncodeOp, tables.mWeight + tables.mEmptyRows > ops{};
+    int n = 0;
+    for( int i = 0; i < R; ++i )
+    {
+       bool is_first = true;
+       for( int k = 0; k < Tables::K; ++k )
+       {
+          if( ( ( tables.mHsys[ i ][ k / BitMatrix::kWordBits ] >> ( k % BitMatrix::kWordBits ) ) & 1 ) == 0 )
+             continue;
+          ops[ n++ ] = { Tables::K + i, k, is_first };
+          is_first = false;
+       }
+       if( is_first )
+          ops[ n++ ] = { Tables::K + i, -1, true };
+    }
+    return ops;
+ }
+
+ template< int R >
+ inline constexpr auto kExtendedHammingEncodeOps = MakeExtendedHammingEncodeOps< R >();
+
+ template< int R, std::size_t I >
+ inline void ApplyEncodeOp( std::byte* const* symbols, std::size_t bytes )
+ {
+    constexpr EncodeOp op = kExtendedHammingEncodeOps< R >[ I ];
+    if constexpr( op.mSrc == -1 )
+       std::memset( symbols[ op.mDst ], 0, bytes );
+    else if constexpr( op.mIsFirst )
+       std::memcpy( symbols[ op.mDst ], symbols[ op.mSrc ], bytes );
+    else
+       XorInto( symbols[ op.mDst ], symbols[ op.mSrc ], bytes );
+ }
+
+ template< int R, std::size_t... I >
+ inline void EncodeExtendedHammingUnrolled( std::byte* const* symbols, std::size_t bytes, std::index_sequence< I... > )
+ {
+    ( ApplyEncodeOp< R, I >( symbols, bytes ), ... );
+ }
+
+ /**
+  * Кодирование встроенным кодом по расписанию, развернутому на этапе компиляции (без обращений к матрице и ветвлений).
+  * @param symbols - N указателей на символы в порядке систематического кода; проверочные символы записываются в K..N-1.
+  */
+ template< int R >
+ inline void EncodeExtendedHamming( std::byte* const* symbols, std::size_t bytes )
+ {
+    EncodeExtendedHammingUnrolled< R >( symbols, bytes,
+                                        std::make_index_sequence< kExtendedHammingEncodeOps< R >.size() >{} );
+ }
+
+ /**
+  * Размер порции символа при проверке синдрома: порция синдрома остается в кэше L1,
+  * а ненулевой синдром обнаруживается, не дочитав длинный символ.
+  */
+ inline constexpr std::size_t kVerifyChunkBytes = 4096;
+
+ /**
+  * Полоса, не прошедшая проверку целостности.
+  */
+ struct VerifyFailure
+ {
+    /**
+     * Индекс полосы в наборе.
+     */
+    std::size_t mStripe;
+
+    /**
+     * Строки матрицы mHsys с ненулевым синдромом (по возрастанию).
+     */
+    std::vector< int > mRows;
+ };
+
  /**
   * Расширенный векторный код Хэмминга. Декодирование в режиме стирания ошибок.
   * R - количество проверочных символов.
@@ -325,193 +509,1282 @@
          D = code_distance;
       }
       assert(D <= (R + 1));
-      if (H.empty()) {
-         mH.clear();
-         for( int i = 0; i < R; ++i )
-            mH.emplace_back( N, i == 0 );
-         int deg = N / 2;
-         for( int i = 1; i < R; ++i )
-         {
-            for( int j = 0; j < N; ++j )
-               mH[ i ][ j ] = ( ( ( j + 1 ) / deg ) % 2 ) == 1;
-            deg /= 2;
+      mIsBuiltin = H.empty();
+      if constexpr (kHasStaticTables) {
+         if (mIsBuiltin) {
+            LoadStaticTables();
          }
-      } else {
-         assert(H.size() == R);
-         assert(R > 0);
-         N = H.at(0).size();
-         assert(N > R);
-         K = N - R;
-         mH = H;
       }
-      bool is_ok;
-      std::tie(mHsys, mSwaps) = MakeParityMatrixSystematic( mH, is_ok );
-      // show_matrix(mHsys, "Systematic:");
-      assert(is_ok);
+      if (mHsys.Empty()) {
+         if (H.empty()) {
+            mH = MakeExtendedHammingMatrix( R );
+         } else {
+            assert(H.size() == R);
+            assert(R > 0);
+            N = H.at(0).size();
+            assert(N > R);
+            K = N - R;
+            mH = BitMatrix( H );
+         }
+         bool is_ok;
+         std::tie(mHsys, mSwaps) = MakeParityMatrixSystematic( mH, is_ok );
+         // show_matrix(mHsys, "Systematic:");
+         assert(is_ok);
+         mEncodeSchedule = MakeEncodeSchedule();
+      }
+      InitPositions();
     }
- 
+
     /**
-     * Закодировать информационный вектор.
+     * Конструктор по готовому описанию кода (см. LoadCodeDescriptor): систематический вид не вычисляется.
      */
-    CodeWord< T, M > Encode( const CodeWord< T, M >& a )
+    explicit HammingExtended( const CodeDescriptor& descriptor )
     {
-       CodeWord< T, M > result;
-       for( const auto& el : a )
-       {
-          assert( el.mStatus == SymbolStatus::Normal );
-          result.push_back( el );
-       }
+      assert(descriptor.mH.Rows() == R && descriptor.mHsys.Rows() == R);
+      assert(descriptor.mH.Cols() == descriptor.mHsys.Cols() && descriptor.mH.Cols() > R);
+      N = descriptor.mH.Cols();
+      K = N - R;
+      D = descriptor.mD;
+      assert(D <= (R + 1));
+      mIsBuiltin = false;
+      mH = descriptor.mH;
+      mHsys = descriptor.mHsys;
+      mSwaps.assign( descriptor.mSwaps.begin(), descriptor.mSwaps.end() );
+      mEncodeSchedule = descriptor.mEncodeSchedule.Empty() ? MakeEncodeSchedule() : descriptor.mEncodeSchedule;
+      assert(mEncodeSchedule.mInputs == K && mEncodeSchedule.Outputs() == R);
+      InitPositions();
+    }
+
+    /**
+     * Описание кода для сохранения (SaveCodeDescriptor) и быстрого создания кода без вычислений.
+     */
+    CodeDescriptor Descriptor() const
+    {
+       CodeDescriptor descriptor;
+       descriptor.mH = mH;
+       descriptor.mHsys = mHsys;
+       descriptor.mSwaps.assign( mSwaps.begin(), mSwaps.end() );
+       descriptor.mD = D;
+       descriptor.mEncodeSchedule = mEncodeSchedule.Empty() ? MakeEncodeSchedule() : mEncodeSchedule;
+       return descriptor;
+    }
+
+    /**
+     * Расписание кодирования по информационной части mHsys.
+     */
+    XorSchedule MakeEncodeSchedule() const
+    {
+       BitMatrix info( R, K );
        for( int i = 0; i < R; ++i )
-       {
-          CodeElement< T, M > element{ .mStatus = SymbolStatus::Normal, .mSymbol = {} };
-          for( int k = 0; k < K; ++k )
-          {
-             if( mHsys.at( i ).at( k ) == 0 )
-                continue;
-             element = element + a.at( k );
-          }
-          result.push_back( element );
-       }
-       if (!mIsSystematic) {
-          for (const auto& [a, b] : mSwaps) {
-             std::swap( result[ a ], result[ b ] );
-          }
+          for( int k = mHsys.FindInRow( i, 0, K ); k != -1; k = mHsys.FindInRow( i, k + 1, K ) )
+             info.Set( i, k, true );
+       return MakeXorSchedule( info );
+    }
+
+    /**
+     * Позиции символов несистематического кода и разреженная матрица для выщипывания (по mH, mSwaps).
+     */
+    void InitPositions()
+    {
+      mPositions.resize( N );
+      for( int j = 0; j < N; ++j )
+         mPositions[ j ] = j;
+      for (const auto& [a, b] : mSwaps) {
+         std::swap( mPositions[ a ], mPositions[ b ] );
+      }
+      mIndices.resize( N );
+      for( int j = 0; j < N; ++j )
+         mIndices[ mPositions[ j ] ] = j;
+      int edges = 0;
+      for( int i = 0; i < R; ++i )
+         edges += mH.Weight( i );
+      mUsePeeling = edges * kSparseDensity <= R * N;
+      if (mUsePeeling) {
+         mHsparse = SparseMatrix( mH, mPositions );
+      }
+      if constexpr (R <= kMaxMaskR) {
+         mColumnMasks = MakeColumnMasks( mHsys );
+         mSyndromeTable = MakeSyndromeTable( mColumnMasks, R );
+      }
+    }
+
+    /**
+     * Маска восстановимых стертых символов без данных (см. RecoverableMask); бит k - символ erased_ids[ k ].
+     * @param erased_ids - индексы стертых символов в систематическом порядке, не более R.
+     */
+    std::uint64_t RecoverableMask( std::span< const int > erased_ids ) const
+    {
+       static_assert( R <= kMaxMaskR );
+       assert( std::cmp_less_equal( erased_ids.size(), R ) );
+       return hamming::RecoverableMask( mColumnMasks, R, erased_ids );
+    }
+
+    /**
+     * Вернет ли Decode true для набора стираний (систематический порядок): не более R стертых
+     * и все стертые информационные символы восстановимы. Данные не нужны.
+     */
+    bool IsDecodable( std::span< const int > erased_ids ) const
+    {
+       if (std::cmp_greater( erased_ids.size(), R )) {
+          return false;
        }
-       return result;
+       const auto recoverable = RecoverableMask( erased_ids );
+       for( int k = 0; k < static_cast< int >( erased_ids.size() ); ++k )
+          if( erased_ids[ k ] < K && ( ( recoverable >> k ) & 1 ) == 0 )
+             return false;
+       return true;
     }
- 
+
     /**
-     * Вычислить синдром по принятому вектору (без стираний).
+     * План ремонта без данных (см. MakeRepairPlan) по битовой карте стираний: какие нестертые символы
+     * прочитать для восстановления каждого стертого. Индексы в mErased и mReads - позиции кодового слова
+     * с учетом режима кодирования; mErased упорядочен по систематическому индексу.
+     * Возвращает то же, что вернул бы Decode: стертых не больше R и все стертые информационные символы
+     * восстановимы. План строится и при отказе, чтобы восстановить хотя бы часть символов.
      */
-    CodeWord< T, M > CalcSyndrome( const CodeWord< T, M >& v )
+    bool GetRepairPlan( std::span< const std::uint64_t > erasures, RepairPlan& repair ) const
     {
-       CodeWord< T, M > result;
-       const auto& parity_check = mIsSystematic ? mHsys : mH;
-       for( int i = 0; i < R; ++i )
+       assert( std::cmp_greater_equal( erasures.size() * 64, N ) );
+       std::vector< int > ids;
+       for( int j = 0; j < N; ++j )
        {
-          CodeElement< T, M > element{ .mStatus = SymbolStatus::Normal, .mSymbol = {} };
-          for( int k = 0; k < N; ++k ) {
-             if (parity_check.at(i).at(k) == 0)
-                continue;
-             element = element + v.at( k );
-          }
-          result.push_back( element );
+          const int p = Position( j );
+          if( ( erasures[ p / 64 ] >> ( p % 64 ) ) & 1 )
+             ids.push_back( j );
        }
-       return result;
+       hamming::MakeRepairPlan( mHsys, ids, repair, mUsePeeling ? &mHsparse : nullptr );
+       const bool is_ok = std::cmp_less_equal( ids.size(), R ) && repair.IsRecoverable( K );
+       for( auto& j : repair.mErased )
+          j = Position( j );
+       for( auto& j : repair.mReads )
+          j = Position( j );
+       for( std::size_t k = 0; k + 1 < repair.mOffsets.size(); ++k )
+          std::sort( repair.mReads.begin() + repair.mOffsets[ k ], repair.mReads.begin() + repair.mOffsets[ k + 1 ] );
+       return is_ok;
+    }
+
+    /**
+     * Матрица считается разреженной (декодирование выщипыванием), если ее плотность не больше 1 / kSparseDensity.
+     */
+    static constexpr int kSparseDensity = 4;
+
+    /**
+     * Для встроенного кода с данным R матрицы и расписание кодирования вычислены на этапе компиляции.
+     */
+    static constexpr bool kHasStaticTables = R >= 3 && R <= kMaxStaticR;
+
+    /**
+     * Размер кодового символа, байт.
+     */
+    static constexpr std::size_t kSymbolBytes = sizeof( T ) * M;
+
+    /**
+     * Позиция символа систематического кода с индексом j в кодовом слове (с учетом режима кодирования).
+     */
+    int Position( int j ) const
+    {
+       return mIsSystematic ? j : mPositions[ j ];
+    }
+
+    /**
+     * Индекс символа систематического кода, находящегося в позиции p кодового слова (обратное к Position).
+     */
+    int SystematicIndex( int p ) const
+    {
+       return mIsSystematic ? p : mIndices[ p ];
     }
  
     /**
-     * Декодировать принятый вектор в режиме стирания ошибки.
+     * Закодировать информационный вектор.
      */
-    bool Decode( CodeWord< T, M >& v, int& erased, int& was_changed_strategy )
+    CodeWord< T, M > Encode( const CodeWord< T, M >& a )
     {
-       assert(v.size() == N && "Input size is wrong");
-       if (!mIsSystematic) {
-          for (const auto& [a, b] : mSwaps) {
-             std::swap( v[ a ], v[ b ] );
-          }
-       }
-       const auto& parity_check = mHsys;
-       // Определяем индексы стертых символов и формируем столбец свободных членов.
-       std::vector< int > ids;
-       mFreeColumn.clear();
-       for (int j = 0; j < R; ++j) {
-         mFreeColumn.push_back(CodeElement<T, M>{.mStatus = hamming::SymbolStatus::Normal, .mSymbol = {}});
-       }
-       for( int i = 0; i < N; ++i )
+       assert( std::cmp_equal( a.size(), K ) );
+       CodeWord< T, M > result( N, CodeElement< T, M >{ .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+       for( int k = 0; k < K; ++k )
        {
-         if( v.at( i ).mStatus == SymbolStatus::Erased ) {
-            ids.push_back( i );
-         } else {
-            for( int j = 0; j < R; ++j )
-            {
-               if (parity_check.at(j).at(i))
-                  mFreeColumn[j] = mFreeColumn.at(j) + v.at(i);
-            }
-         }
+          assert( a[ k ].mStatus == SymbolStatus::Normal );
+          result[ Position( k ) ] = a[ k ];
        }
-       erased = ids.size();
-       if (erased > R) {
-         return false;
-       }
-       // Выбираем часть проверочной матрицы - подматрицу.
-       auto select_erasure_submatrix = [this, &parity_check](std::vector< int >& ids) {
-          mErasureSubmatrix.clear();
-          const int erased = ids.size();
-         for( int j = 0; j < R; ++j )
-         {
-            mErasureSubmatrix.emplace_back( erased, 0 );
-            for( int i = 0; auto idx : ids )
-               mErasureSubmatrix[ j ][ i++ ] = parity_check.at( j ).at( idx );
-         }
-       };
-       select_erasure_submatrix(ids);
-      auto free_column = mFreeColumn;
-      // show_codeword(free_column, -1, "free column:");
-      // show_matrix(mErasureSubmatrix, "Erasure matrix:");
-      Gauss(free_column, mErasureSubmatrix);
-      // show_codeword(free_column, -1, "free column after Gauss method:");
-      // show_matrix(mErasureSubmatrix, "Erasure matrix after Gauss method:");
-      // Восстанавливаем стертые символы: решение СЛАУ обратным ходом.
-      for( int k = erased - 1; k >= 0; --k ) {
-         // std::cout << " k = " << k << std::endl;
-         const int idx_v = ids.at(k);
-         if (mErasureSubmatrix.at(k).at(k) != 0) {
-            v[ idx_v ] = free_column.at(k);
-            // std::cout << " v = " << std::endl;
-         }
-         for (int j = 0; j < erased - 1 - k; j++) {
-            if (mErasureSubmatrix.at(k).at(k + j + 1) != 0) {
-               v[idx_v] = v.at(idx_v) + v.at(ids.at(k + j + 1));
-               // std::cout << " v += " << std::endl;
-            }
-         }
-      }
-       while (v.size() > K)
-          v.pop_back();
-       return true;
+       std::vector< std::byte* > symbols( N );
+       for( int j = 0; j < N; ++j )
+          symbols[ j ] = reinterpret_cast< std::byte* >( result[ j ].mSymbol.data() );
+       EncodeSymbols( symbols, kSymbolBytes );
+       return result;
     }
 
     /**
-     * 
+     * Закодировать кодовое слово, заданное указателями на символы (без копирования данных).
+     * Информационные символы берутся из позиций Position(0..K-1), проверочные записываются в позиции Position(K..N-1).
+     * @param codeword - N указателей на буферы символов в порядке кодового слова.
+     * @param bytes - размер одного символа, байт (произвольный: алгебра XOR не зависит от M).
      */
-    auto getSwaps() const {
-      return mSwaps;
+    void EncodeSymbols( std::span< std::byte* const > codeword, std::size_t bytes ) const
+    {
+       EncodeRange( codeword, 0, bytes );
     }
- 
+
     /**
-     * Включить/выключить режим систематического кодирования. 
+     * Закодировать кодовое слово в пуле потоков: символы делятся на порции kParallelChunkBytes,
+     * порции кодируются независимо. Результат побитово совпадает с последовательным EncodeSymbols.
      */
-    void SwitchToSystematic(bool is_systematic) {
-       mIsSystematic = is_systematic;
+    void EncodeSymbols( std::span< std::byte* const > codeword, std::size_t bytes, ThreadPool& pool ) const
+    {
+       ParallelChunks( pool, 1, bytes, [this, codeword]( std::size_t, std::size_t offset, std::size_t n ) {
+          EncodeRange( codeword, offset, n );
+       } );
     }
- 
-    bool mIsSystematic = true;
- 
+
     /**
-     * Сделанные во время формирования систематической матрицы перестановки столбцов. 
+     * Закодировать набор независимых полос (кодовых слов) в пуле потоков; задачи - порции всех полос.
+     * @param stripes - полосы, в каждой N указателей на буферы символов в порядке кодового слова.
      */
-    Swaps< int > mSwaps;
- 
+    void EncodeStripes( std::span< const std::span< std::byte* const > > stripes, std::size_t bytes,
+                        ThreadPool& pool ) const
+    {
+       ParallelChunks( pool, stripes.size(), bytes, [this, stripes]( std::size_t s, std::size_t offset, std::size_t n ) {
+          EncodeRange( stripes[ s ], offset, n );
+       } );
+    }
+
     /**
-     * Проверочная матрица кода (несистематическая).
+     * Закодировать байты [offset, offset + bytes) каждого символа кодового слова.
      */
-    Matrix< int > mH;
- 
+    void EncodeRange( std::span< std::byte* const > codeword, std::size_t offset, std::size_t bytes ) const
+    {
+       assert( std::cmp_equal( codeword.size(), N ) );
+       if constexpr (kHasStaticTables) {
+          if (mIsBuiltin) {
+             std::array< std::byte*, ExtendedHammingTables< R >::N > symbols;
+             for( int j = 0; j < ExtendedHammingTables< R >::N; ++j )
+                symbols[ j ] = codeword[ Position( j ) ] + offset;
+             EncodeExtendedHamming< R >( symbols.data(), bytes );
+             return;
+          }
+       }
+       ApplyXorSchedule( mEncodeSchedule,
+                         [this, codeword, offset]( int k ) -> const std::byte* { return codeword[ Position( k ) ] + offset; },
+                         [this, codeword, offset]( int i ) { return codeword[ Position( K + i ) ] + offset; }, bytes );
+    }
+
     /**
-     * Проверочная матрица систематического кода.
+     * Количество XOR на одно кодовое слово при кодировании: по расписанию и при построчном вычислении.
+     */
+    std::pair< int, int > EncodeXorCount() const
+    {
+       if constexpr (kHasStaticTables) {
+          if (mIsBuiltin) {
+             // В развернутом расписании на каждую строку одна операция копирования (обнуления).
+             const int count = kExtendedHammingEncodeOps< R >.size() - R;
+             return std::make_pair( count, count );
+          }
+       }
+       return std::make_pair( mEncodeSchedule.XorCount(), mEncodeSchedule.mNaiveXors );
+    }
+
+    /**
+     * Обновить проверочные символы после изменения одного информационного символа (малая запись).
+     * Приращение old ^ new прибавляется только к проверочным символам, в строках которых столбец символа
+     * матрицы mHsys равен единице; остальные информационные символы не читаются.
+     * @param position - позиция измененного символа в кодовом слове (с учетом режима кодирования).
+     * @param old_symbol, new_symbol - прежнее и новое значения символа.
+     * @param codeword - N указателей в порядке кодового слова; используются только указатели проверочных символов.
+     * @param bytes - размер одного символа, байт.
+     * Возвращает false, если в позиции position находится проверочный символ.
+     */
+    bool UpdateParitySymbols( int position, const std::byte* old_symbol, const std::byte* new_symbol,
+                              std::span< std::byte* const > codeword, std::size_t bytes ) const
+    {
+       assert( std::cmp_equal( codeword.size(), N ) );
+       assert( position >= 0 && position < N );
+       const int k = SystematicIndex( position );
+       if (k >= K) {
+          return false;
+       }
+       // Приращение считается порциями в буфере потока, чтобы не выделять память под весь символ.
+       const std::size_t chunk = std::min( bytes, kParallelChunkBytes );
+       std::byte* delta = XorScratch( chunk );
+       for( std::size_t offset = 0; offset < bytes; offset += chunk )
+       {
+          const std::size_t n = std::min( chunk, bytes - offset );
+          std::memcpy( delta, old_symbol + offset, n );
+          XorInto( delta, new_symbol + offset, n );
+          for( int i = mHsys.FindInColumn( k ); i != -1; i = mHsys.FindInColumn( k, i + 1 ) )
+             XorInto( codeword[ Position( K + i ) ] + offset, delta, n );
+       }
+       return true;
+    }
+
+    /**
+     * Обновить проверочные символы кодового слова после изменения символа в позиции position.
+     * Параметры - как у UpdateParitySymbols; сам символ codeword[ position ] не изменяется.
+     */
+    bool UpdateParity( int position, const CodeElement< T, M >& old_symbol, const CodeElement< T, M >& new_symbol,
+                       CodeWord< T, M >& codeword ) const
+    {
+       assert( std::cmp_equal( codeword.size(), N ) );
+       assert( position >= 0 && position < N );
+       const int k = SystematicIndex( position );
+       if (k >= K) {
+          return false;
+       }
+       const auto delta = old_symbol + new_symbol;
+       for( int i = mHsys.FindInColumn( k ); i != -1; i = mHsys.FindInColumn( k, i + 1 ) )
+          codeword[ Position( K + i ) ] += delta;
+       return true;
+    }
+
+    /**
+     * Восстановить стертые символы по месту в буферах вызывающей стороны.
+     * @param codeword - N указателей на буферы символов в порядке кодового слова.
+     * @param erasures - битовая карта стираний: бит p (слово p / 64) установлен, если символ в позиции p стерт.
+     * @param bytes - размер одного символа, байт.
+     * @param erased - количество стертых символов.
+     * Невосстановимые символы не изменяются. Возвращает false, если не восстановлен какой-либо информационный символ.
+     */
+    bool DecodeSymbols( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                        std::size_t bytes, int& erased )
+    {
+       const DecodeMetrics metrics;
+       assert( std::cmp_equal( codeword.size(), N ) );
+       std::shared_ptr< const RecoveryPlan > plan;
+       if (!FindRecoveryPlan( erasures, erased, plan)) {
+          return metrics.Finish( erased, R, false );
+       }
+       if (!plan) {
+          return metrics.Finish( erased, R, true );
+       }
+       ApplyRecoveryPlan( *plan, codeword, bytes );
+       return metrics.Finish( erased, R, plan->IsRecoverable( K ) );
+    }
+
+    /**
+     * Восстановить стертые символы в пуле потоков. План строится один раз, порции символов
+     * восстанавливаются независимо; результат побитово совпадает с последовательным DecodeSymbols.
+     */
+    bool DecodeSymbols( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                        std::size_t bytes, int& erased, ThreadPool& pool )
+    {
+       const std::span< std::byte* const > stripes[] = { codeword };
+       return DecodeStripes( stripes, erasures, bytes, erased, pool );
+    }
+
+    /**
+     * Восстановить набор полос с одинаковой картой стираний (например, отказ одного диска) в пуле потоков.
+     * @param stripes - полосы, в каждой N указателей на буферы символов в порядке кодового слова.
+     * Остальные параметры - как у DecodeSymbols.
+     */
+    bool DecodeStripes( std::span< const std::span< std::byte* const > > stripes,
+                        std::span< const std::uint64_t > erasures, std::size_t bytes, int& erased, ThreadPool& pool )
+    {
+       const DecodeMetrics metrics;
+       std::shared_ptr< const RecoveryPlan > plan;
+       if (!FindRecoveryPlan( erasures, erased, plan)) {
+          return metrics.Finish( erased, R, false );
+       }
+       if (!plan) {
+          return metrics.Finish( erased, R, true );
+       }
+       ParallelChunks( pool, stripes.size(), bytes,
+                       [this, stripes, &plan]( std::size_t s, std::size_t offset, std::size_t n ) {
+          assert( std::cmp_equal( stripes[ s ].size(), N ) );
+          ApplyRecoveryPlan( *plan, stripes[ s ], n, offset );
+       } );
+       return metrics.Finish( erased, R, plan->IsRecoverable( K ) );
+    }
+
+    /**
+     * Найти план восстановления по битовой карте стираний (из кэша либо построенный заново).
+     * Возвращает false, если стертых символов больше R; при отсутствии стираний plan пуст.
+     */
+    bool FindRecoveryPlan( std::span< const std::uint64_t > erasures, int& erased,
+                           std::shared_ptr< const RecoveryPlan >& plan )
+    {
+       assert( std::cmp_greater_equal( erasures.size() * 64, N ) );
+       mErasedIds.clear();
+       for( int j = 0; j < N; ++j )
+       {
+          const int p = Position( j );
+          if( ( erasures[ p / 64 ] >> ( p % 64 ) ) & 1 )
+             mErasedIds.push_back( j );
+       }
+       erased = mErasedIds.size();
+       plan = nullptr;
+       if (erased > R) {
+          return false;
+       }
+       if (erased > 0) {
+          plan = GetRecoveryPlan( mErasedIds );
+       }
+       return true;
+    }
+ 
+    /**
+     * Вычислить синдром по принятому вектору (без стираний).
+     */
+    CodeWord< T, M > CalcSyndrome( const CodeWord< T, M >& v )
+    {
+       assert( std::cmp_equal( v.size(), N ) );
+       CodeWord< T, M > result( R, CodeElement< T, M >{ .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+       const auto& parity_check = mIsSystematic ? mHsys : mH;
+       for( int i = 0; i < R; ++i )
+       {
+          auto& element = result[ i ];
+          for( int k = parity_check.FindInRow( i, 0, N ); k != -1; k = parity_check.FindInRow( i, k + 1, N ) ) {
+             element += v[ k ];
+          }
+       }
+       return result;
+    }
+
+    /**
+     * Проверить целостность кодового слова по синдрому без декодирования: синдром строки i матрицы mHsys
+     * складывается порциями kVerifyChunkBytes в буфере потока и должен быть нулевым.
+     * @param codeword - N указателей на буферы символов в порядке кодового слова.
+     * @param bytes - размер одного символа, байт.
+     * @param rows - битовая карта строк с ненулевым синдромом (бит i, слово i / 64), не меньше (R + 63) / 64 слов.
+     * Если карта пуста, проверка прекращается на первой ненулевой порции синдрома.
+     * Возвращает true, если синдром нулевой.
+     */
+    bool VerifySymbols( std::span< std::byte* const > codeword, std::size_t bytes,
+                        std::span< std::uint64_t > rows = {} ) const
+    {
+       assert( std::cmp_equal( codeword.size(), N ) );
+       assert( rows.empty() || std::cmp_greater_equal( rows.size() * 64, R ) );
+       std::fill( rows.begin(), rows.end(), 0 );
+       const std::size_t chunk = std::min( bytes, kVerifyChunkBytes );
+       std::byte* syndrome = XorScratch( chunk );
+       bool is_ok = true;
+       for( std::size_t offset = 0; offset < bytes; offset += chunk )
+       {
+          const std::size_t n = std::min( chunk, bytes - offset );
+          for( int i = 0; i < R; ++i )
+          {
+             if( !rows.empty() && ( ( rows[ i / 64 ] >> ( i % 64 ) ) & 1 ) )
+                continue;
+             int j = mHsys.FindInRow( i, 0, N );
+             if( j == -1 )
+                continue;
+             std::memcpy( syndrome, codeword[ Position( j ) ] + offset, n );
+             for( j = mHsys.FindInRow( i, j + 1, N ); j != -1; j = mHsys.FindInRow( i, j + 1, N ) )
+                XorInto( syndrome, codeword[ Position( j ) ] + offset, n );
+             if( IsZero( syndrome, n ) )
+                continue;
+             if( rows.empty() )
+                return false;
+             rows[ i / 64 ] |= std::uint64_t( 1 ) << ( i % 64 );
+             is_ok = false;
+          }
+       }
+       return is_ok;
+    }
+
+    /**
+     * Проверить целостность набора полос (проверка данных, scrub). Память выделяется только под результат.
+     * @param stripes - полосы, в каждой N указателей на буферы символов в порядке кодового слова.
+     * Возвращает только не прошедшие проверку полосы, по возрастанию индекса.
+     */
+    std::vector< VerifyFailure > VerifyStripes( std::span< const std::span< std::byte* const > > stripes,
+                                                std::size_t bytes ) const
+    {
+       std::vector< VerifyFailure > failures;
+       std::array< std::uint64_t, ( R + 63 ) / 64 > rows;
+       for( std::size_t s = 0; s < stripes.size(); ++s )
+          if( !VerifySymbols( stripes[ s ], bytes, rows ) )
+             failures.push_back( MakeVerifyFailure( s, rows ) );
+       return failures;
+    }
+
+    /**
+     * Проверить набор полос в пуле потоков; задача - группа полос общим объемом около kParallelChunkBytes на символ.
+     * Результат совпадает с последовательным VerifyStripes.
+     */
+    std::vector< VerifyFailure > VerifyStripes( std::span< const std::span< std::byte* const > > stripes,
+                                                std::size_t bytes, ThreadPool& pool ) const
+    {
+       constexpr std::size_t kWords = ( R + 63 ) / 64;
+       const std::size_t group = std::max< std::size_t >( 1, kParallelChunkBytes / std::max< std::size_t >( bytes, 1 ) );
+       const std::size_t tasks = ( stripes.size() + group - 1 ) / group;
+       std::vector< std::uint64_t > rows( stripes.size() * kWords );
+       std::vector< char > is_failed( stripes.size(), 0 );
+       pool.ParallelFor( tasks, [&]( std::size_t task ) {
+          const std::size_t last = std::min( stripes.size(), ( task + 1 ) * group );
+          for( std::size_t s = task * group; s < last; ++s )
+             is_failed[ s ] = !VerifySymbols( stripes[ s ], bytes, std::span( rows ).subspan( s * kWords, kWords ) );
+       } );
+       std::vector< VerifyFailure > failures;
+       for( std::size_t s = 0; s < stripes.size(); ++s )
+          if( is_failed[ s ] )
+             failures.push_back( MakeVerifyFailure( s, std::span( rows ).subspan( s * kWords, kWords ) ) );
+       return failures;
+    }
+
+    /**
+     * Декодировать с исправлением ошибок и стираний по месту в буферах вызывающей стороны: сначала по синдрому
+     * находится и исправляется один ошибочный символ с неизвестной позицией (CorrectError), затем
+     * восстанавливаются стертые символы, как в DecodeSymbols. Отдельный проход проверки данных не нужен.
+     * @param corrected - 1, если ошибочный символ исправлен, иначе 0.
+     * Остальные параметры - как у DecodeSymbols. Возвращает false, если стертых символов больше R,
+     * обнаружена неисправимая ошибка (символы не изменяются) или не восстановлен информационный символ.
+     */
+    bool DecodeErrors( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                       std::size_t bytes, int& erased, int& corrected )
+    {
+       const DecodeMetrics metrics;
+       assert( std::cmp_equal( codeword.size(), N ) );
+       corrected = 0;
+       std::shared_ptr< const RecoveryPlan > plan;
+       if (!FindRecoveryPlan( erasures, erased, plan )) {
+          return metrics.Finish( erased, R, false );
+       }
+       if (!CorrectError( codeword, mErasedIds, bytes, corrected )) {
+          return metrics.FinishDetected( erased );
+       }
+       if (!plan) {
+          return metrics.Finish( erased, R, true );
+       }
+       ApplyRecoveryPlan( *plan, codeword, bytes );
+       return metrics.Finish( erased, R, plan->IsRecoverable( K ) );
+    }
+
+    /**
+     * Декодировать принятый вектор с исправлением ошибок и стираний: исправление одного ошибочного символа
+     * (CorrectError), затем восстановление стертых, как в Decode. При обнаруженной неисправимой ошибке
+     * вектор не изменяется.
+     * @param corrected - 1, если ошибочный символ исправлен, иначе 0.
+     */
+    bool DecodeErrors( CodeWord< T, M >& v, int& erased, int& corrected )
+    {
+       const DecodeMetrics metrics;
+       assert( std::cmp_equal( v.size(), N ) && "Input size is wrong" );
+       corrected = 0;
+       mErasedIds.clear();
+       for( int j = 0; j < N; ++j )
+       {
+          if( v[ Position( j ) ].mStatus == SymbolStatus::Erased )
+             mErasedIds.push_back( j );
+       }
+       erased = mErasedIds.size();
+       if (erased > R) {
+          return metrics.Finish( erased, R, false );
+       }
+       std::vector< std::byte* > symbols( N );
+       for( int p = 0; p < N; ++p )
+          symbols[ p ] = reinterpret_cast< std::byte* >( v[ p ].mSymbol.data() );
+       if (!CorrectError( symbols, mErasedIds, kSymbolBytes, corrected )) {
+          return metrics.FinishDetected( erased );
+       }
+       ToSystematicOrder( v );
+       bool is_ok = true;
+       if (erased > 0) {
+          const auto plan = GetRecoveryPlan( mErasedIds );
+          ApplyRecoveryPlan( *plan, v );
+          is_ok = plan->IsRecoverable( K );
+       }
+       v.resize( K );
+       return metrics.Finish( erased, R, is_ok );
+    }
+
+    /**
+     * Найти и исправить по месту один ошибочный символ с неизвестной позицией (стертые символы не проверяются).
+     * Синдром строк mHsys складывается по нестертым символам порциями kVerifyChunkBytes в буфере потока
+     * и приводится к базису столбцов стертых (ErasureBasis), так что остаются только проверки без стертых символов.
+     * При одной ошибке e в символе j все ненулевые строки порции синдрома равны порции e, а их набор во всех
+     * ненулевых порциях один и тот же - приведенный столбец j, который находится по таблице mSyndromeTable
+     * (без стираний) либо перебором столбцов.
+     * Первый проход только проверяет порции; если ошибка найдена, последняя порция исправляется из буфера,
+     * а остальные порции с ненулевым синдромом пересчитываются вторым проходом (символ не длиннее
+     * kVerifyChunkBytes читается один раз).
+     * Исправление допустимо, пока 2 + erased < D; при большем числе стираний ненулевой синдром только обнаруживается.
+     * @param erased_ids - стертые символы (систематический порядок, по возрастанию), не больше R.
+     * @param corrected - 1, если символ исправлен, иначе 0.
+     * Возвращает false, если обнаружена неисправимая ошибка; символы при этом не изменяются.
+     */
+    bool CorrectError( std::span< std::byte* const > codeword, std::span< const int > erased_ids, std::size_t bytes,
+                       int& corrected ) const
+    {
+       static_assert( R <= kMaxMaskR, "Error correction requires R <= kMaxMaskR" );
+       assert( std::cmp_less_equal( erased_ids.size(), R ) );
+       corrected = 0;
+       const ErasureBasis basis( mColumnMasks, erased_ids );
+       const bool is_correctable = std::cmp_less( erased_ids.size() + 2, D );
+       const std::size_t chunk = std::min( bytes, kVerifyChunkBytes );
+       std::byte* syndrome = XorScratch( R * chunk );
+       std::uint64_t pattern = 0;
+       std::size_t first = bytes;
+       std::size_t last = 0;
+       for( std::size_t offset = 0; offset < bytes; offset += chunk )
+       {
+          const std::size_t n = std::min( chunk, bytes - offset );
+          const std::uint64_t chunk_pattern = ReducedSyndrome( codeword, erased_ids, basis, offset, n, syndrome, chunk );
+          if( chunk_pattern == 0 )
+             continue;
+          if( !is_correctable || ( pattern != 0 && chunk_pattern != pattern ) )
+             return false;
+          // Все ненулевые строки порции равны порции ошибки.
+          const std::byte* error = syndrome + std::countr_zero( chunk_pattern ) * chunk;
+          for( std::uint64_t rest = chunk_pattern & ( chunk_pattern - 1 ); rest != 0; rest &= rest - 1 )
+             if( std::memcmp( syndrome + std::countr_zero( rest ) * chunk, error, n ) != 0 )
+                return false;
+          pattern = chunk_pattern;
+          first = std::min( first, offset );
+          last = offset;
+       }
+       if (pattern == 0) {
+          return true;
+       }
+       const int j = LocateErrorColumn( mColumnMasks, mSyndromeTable, basis, pattern );
+       if (j < 0) {
+          return false;
+       }
+       // Последняя порция еще в буфере и исправляется первой; порции не пересекаются, поэтому исправление
+       // не меняет синдром остальных.
+       std::byte* target = codeword[ Position( j ) ];
+       const std::size_t tail = ( bytes - 1 ) / chunk * chunk;
+       if( last == tail )
+          XorInto( target + tail, syndrome + std::countr_zero( pattern ) * chunk, bytes - tail );
+       for( std::size_t offset = first; offset <= last && offset < tail; offset += chunk )
+       {
+          const std::uint64_t chunk_pattern = ReducedSyndrome( codeword, erased_ids, basis, offset, chunk, syndrome, chunk );
+          if( chunk_pattern != 0 )
+             XorInto( target + offset, syndrome + std::countr_zero( chunk_pattern ) * chunk, chunk );
+       }
+       AddMetric( Metric::CorrectedErrors );
+       corrected = 1;
+       return true;
+    }
+
+    /**
+     * Порция [offset, offset + n) синдрома строк mHsys по нестертым символам, приведенная к базису стертых:
+     * строка ведущего элемента складывается с остальными строками его столбца и обнуляется.
+     * @param syndrome - R строк порции с шагом stride >= n.
+     * Возвращает битовую карту ненулевых строк.
+     */
+    std::uint64_t ReducedSyndrome( std::span< std::byte* const > codeword, std::span< const int > erased_ids,
+                                   const ErasureBasis& basis, std::size_t offset, std::size_t n,
+                                   std::byte* syndrome, std::size_t stride ) const
+    {
+       for( int i = 0; i < R; ++i )
+       {
+          std::byte* row = syndrome + i * stride;
+          bool is_empty = true;
+          for( int j = mHsys.FindInRow( i, 0, N ); j != -1; j = mHsys.FindInRow( i, j + 1, N ) )
+          {
+             if( std::binary_search( erased_ids.begin(), erased_ids.end(), j ) )
+                continue;
+             if( is_empty )
+                std::memcpy( row, codeword[ Position( j ) ] + offset, n );
+             else
+                XorInto( row, codeword[ Position( j ) ] + offset, n );
+             is_empty = false;
+          }
+          if( is_empty )
+             std::memset( row, 0, n );
+       }
+       for( std::uint64_t pivots = basis.mPivots; pivots != 0; pivots &= pivots - 1 )
+       {
+          const int p = std::countr_zero( pivots );
+          std::byte* pivot_row = syndrome + p * stride;
+          for( std::uint64_t rest = basis.mBasis[ p ] & ( basis.mBasis[ p ] - 1 ); rest != 0; rest &= rest - 1 )
+             XorInto( syndrome + std::countr_zero( rest ) * stride, pivot_row, n );
+          std::memset( pivot_row, 0, n );
+       }
+       std::uint64_t pattern = 0;
+       for( int i = 0; i < R; ++i )
+          if( !IsZero( syndrome + i * stride, n ) )
+             pattern |= std::uint64_t( 1 ) << i;
+       return pattern;
+    }
+
+    /**
+     * Декодировать принятый вектор в режиме стирания ошибки.
+     * @param was_changed_strategy - 1, если план восстановления построен заново (нет в кэше), иначе 0.
+     * Возвращает false, если стертых символов больше R или какой-либо стертый информационный символ
+     * не определяется однозначно.
+     */
+    bool Decode( CodeWord< T, M >& v, int& erased, int& was_changed_strategy )
+    {
+       const DecodeMetrics metrics;
+       assert(v.size() == N && "Input size is wrong");
+       ToSystematicOrder( v );
+       const auto ids = FindErased( v );
+       erased = ids.size();
+       was_changed_strategy = 0;
+       if (erased > R) {
+         return metrics.Finish( erased, R, false );
+       }
+       bool is_ok = true;
+       if (erased > 0) {
+          bool is_built;
+          const auto plan = GetRecoveryPlan( ids, is_built );
+          was_changed_strategy = is_built;
+          ApplyRecoveryPlan( *plan, v );
+          is_ok = plan->IsRecoverable( K );
+       }
+       while (v.size() > K)
+          v.pop_back();
+       return metrics.Finish( erased, R, is_ok );
+    }
+
+    /**
+     * Декодировать принятый вектор в режиме стирания ошибки, используя рабочую область вызывающей стороны.
+     * Не меняет объект кода и в установившемся режиме не выделяет память: один код обслуживает все потоки,
+     * у каждого потока своя рабочая область.
+     */
+    bool Decode( CodeWord< T, M >& v, int& erased, DecodeWorkspace& workspace ) const
+    {
+       const DecodeMetrics metrics;
+       assert(std::cmp_equal( v.size(), N ) && "Input size is wrong");
+       ToSystematicOrder( v );
+       erased = CollectErased( workspace, [&v]( int j ) { return v[ j ].mStatus == SymbolStatus::Erased; } );
+       if (erased > R) {
+         return metrics.Finish( erased, R, false );
+       }
+       bool is_ok = true;
+       if (erased > 0) {
+          const auto& plan = workspace.Plan( mHsys, mUsePeeling ? &mHsparse : nullptr );
+          ApplyRecoveryPlan( plan, v );
+          is_ok = plan.IsRecoverable( K );
+       }
+       v.resize( K );
+       return metrics.Finish( erased, R, is_ok );
+    }
+
+    /**
+     * Восстановить стертые символы по месту в буферах вызывающей стороны, используя рабочую область.
+     * Параметры те же, что у DecodeSymbols без рабочей области. Не меняет объект кода и не выделяет память.
+     */
+    bool DecodeSymbols( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                        std::size_t bytes, int& erased, DecodeWorkspace& workspace ) const
+    {
+       const DecodeMetrics metrics;
+       assert( std::cmp_equal( codeword.size(), N ) );
+       assert( std::cmp_greater_equal( erasures.size() * 64, N ) );
+       erased = CollectErased( workspace, [this, erasures]( int j ) {
+          const int p = Position( j );
+          return ( ( erasures[ p / 64 ] >> ( p % 64 ) ) & 1 ) != 0;
+       } );
+       if (erased > R) {
+          return metrics.Finish( erased, R, false );
+       }
+       if (erased == 0) {
+          return metrics.Finish( erased, R, true );
+       }
+       const auto& plan = workspace.Plan( mHsys, mUsePeeling ? &mHsparse : nullptr );
+       ApplyRecoveryPlan( plan, codeword, bytes );
+       return metrics.Finish( erased, R, plan.IsRecoverable( K ) );
+    }
+
+    /**
+     * Чтение в деградированном режиме: восстановить только символ в позиции position по буферам вызывающей
+     * стороны, читая и складывая лишь символы его комбинации. Если план для набора стираний есть в кэше,
+     * берется его строка, иначе исключение выполняется только для этого символа и план не кэшируется
+     * (для разреженных кодов строится план выщипыванием).
+     * Возвращает false, если стертых символов больше R или символ невосстановим; нестертый символ не изменяется.
+     */
+    bool DecodeSymbol( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                       int position, std::size_t bytes )
+    {
+       if (!mSymbolWorkspace) {
+          mSymbolWorkspace.emplace( R, N );
+       }
+       auto& workspace = *mSymbolWorkspace;
+       const DecodeMetrics metrics;
+       int k;
+       if (!FindErasedSlot( erasures, position, workspace, k)) {
+          return metrics.Finish( kMetricsEnabled ? CountErasures( erasures ) : 0, R, false );
+       }
+       if (k == -1) {
+          return metrics.Finish( kMetricsEnabled ? CountErasures( erasures ) : 0, R, true );
+       }
+       const int erased = workspace.mErased.size();
+       if (auto plan = mRecoveryCache.Find( workspace.mErased )) {
+          AddMetric( Metric::PlanCacheHits );
+          if (!RecoverySources( *plan, k, workspace.mSources )) {
+             return metrics.Finish( erased, R, false );
+          }
+       } else if (!workspace.SymbolSources( mHsys, k, mUsePeeling ? &mHsparse : nullptr )) {
+          return metrics.Finish( erased, R, false );
+       }
+       XorSources( codeword[ position ], workspace.mSources, codeword, bytes );
+       return metrics.Finish( erased, R, true );
+    }
+
+    /**
+     * Чтение в деградированном режиме с рабочей областью вызывающей стороны: не меняет объект кода
+     * и не выделяет память. Если в рабочей области уже есть план для этого набора стираний, берется его строка.
+     */
+    bool DecodeSymbol( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                       int position, std::size_t bytes, DecodeWorkspace& workspace ) const
+    {
+       const DecodeMetrics metrics;
+       int k;
+       if (!FindErasedSlot( erasures, position, workspace, k)) {
+          return metrics.Finish( kMetricsEnabled ? CountErasures( erasures ) : 0, R, false );
+       }
+       if (k == -1) {
+          return metrics.Finish( kMetricsEnabled ? CountErasures( erasures ) : 0, R, true );
+       }
+       const int erased = workspace.mErased.size();
+       if (!workspace.SymbolSources( mHsys, k, mUsePeeling ? &mHsparse : nullptr )) {
+          return metrics.Finish( erased, R, false );
+       }
+       XorSources( codeword[ position ], workspace.mSources, codeword, bytes );
+       return metrics.Finish( erased, R, true );
+    }
+
+    /**
+     * Рабочая область декодера для данного кода.
+     */
+    DecodeWorkspace MakeWorkspace() const
+    {
+       return DecodeWorkspace( R, N );
+    }
+
+    /**
+     * Декодировать пачку принятых векторов с одинаковым набором стертых символов (например, при отказе диска
+     * стерт один и тот же столбец всех полос). Набор стираний определяется по первому вектору; план восстановления
+     * строится (или берется из кэша) один раз и применяется ко всем векторам.
+     * @param words - принятые векторы, dim = N; после декодирования dim = K.
+     * Векторы с другим набором стертых символов не изменяются (остаются dim = N), результат при этом - false.
+     */
+    bool DecodeBatch( std::span< CodeWord< T, M > > words, int& erased )
+    {
+       const DecodeMetrics metrics;
+       erased = 0;
+       if (words.empty()) {
+          return metrics.Finish( erased, R, true );
+       }
+       const auto positions = PrepareBatch( words );
+       erased = positions.size();
+       if (erased > R) {
+          return metrics.Finish( erased, R, false );
+       }
+       bool is_ok = true;
+       std::shared_ptr< const RecoveryPlan > plan;
+       if (erased > 0) {
+          plan = GetRecoveryPlan( BatchErasedIds( positions ) );
+          is_ok = plan->IsRecoverable( K );
+       }
+       for (auto& v : words) {
+          if (!IsErasedExactly( v, positions )) {
+             is_ok = false;
+             continue;
+          }
+          ToSystematicOrder( v );
+          if (plan) {
+             ApplyRecoveryPlan( *plan, v );
+          }
+          v.resize( K );
+       }
+       return metrics.Finish( erased, R, is_ok );
+    }
+
+    /**
+     * Декодировать пачку принятых векторов в пуле потоков: векторы делятся на группы
+     * примерно по kParallelChunkBytes байт. Параметры и результат - как у DecodeBatch.
+     */
+    bool DecodeBatch( std::span< CodeWord< T, M > > words, int& erased, ThreadPool& pool )
+    {
+       const DecodeMetrics metrics;
+       erased = 0;
+       if (words.empty()) {
+          return metrics.Finish( erased, R, true );
+       }
+       const auto positions = PrepareBatch( words );
+       erased = positions.size();
+       if (erased > R) {
+          return metrics.Finish( erased, R, false );
+       }
+       std::shared_ptr< const RecoveryPlan > plan;
+       if (erased > 0) {
+          plan = GetRecoveryPlan( BatchErasedIds( positions ) );
+       }
+       const std::size_t group = std::max< std::size_t >( 1, kParallelChunkBytes / ( N * kSymbolBytes ) );
+       const std::size_t groups = ( words.size() + group - 1 ) / group;
+       // Признак "в группе есть вектор с другим набором стираний": байт на группу, группы пишут без гонок.
+       std::vector< std::uint8_t > is_mismatched( groups, 0 );
+       pool.ParallelFor( groups, [this, words, group, &positions, &plan, &is_mismatched]( std::size_t g ) {
+          for (auto& v : words.subspan( g * group, std::min( group, words.size() - g * group ) )) {
+             if (!IsErasedExactly( v, positions )) {
+                is_mismatched[ g ] = 1;
+                continue;
+             }
+             ToSystematicOrder( v );
+             if (plan) {
+                ApplyRecoveryPlan( *plan, v );
+             }
+             v.resize( K );
+          }
+       } );
+       const bool is_same = std::find( is_mismatched.begin(), is_mismatched.end(), 1 ) == is_mismatched.end();
+       return metrics.Finish( erased, R, is_same && ( !plan || plan->IsRecoverable( K ) ) );
+    }
+
+    /**
+     * Проверить размеры векторов пачки и найти позиции стертых символов первого вектора (порядок приема).
+     */
+    std::vector< int > PrepareBatch( std::span< const CodeWord< T, M > > words ) const
+    {
+       for ([[maybe_unused]] const auto& v : words) {
+          assert(std::cmp_equal( v.size(), N ) && "Input size is wrong");
+       }
+       return FindErased( words.front() );
+    }
+
+    /**
+     * Индексы стертых символов систематического кода (по возрастанию) по их позициям в принятом векторе.
+     */
+    std::vector< int > BatchErasedIds( const std::vector< int >& positions ) const
+    {
+       std::vector< int > ids;
+       ids.reserve( positions.size() );
+       for (int p : positions) {
+          ids.push_back( SystematicIndex( p ) );
+       }
+       std::sort( ids.begin(), ids.end() );
+       return ids;
+    }
+
+    /**
+     * Стерты ли в принятом векторе в точности символы в позициях positions (по возрастанию).
+     */
+    bool IsErasedExactly( const CodeWord< T, M >& v, const std::vector< int >& positions ) const
+    {
+       std::size_t count = 0;
+       for (int p = 0; p < N; ++p) {
+          if (v[ p ].mStatus != SymbolStatus::Erased) {
+             continue;
+          }
+          if (count == positions.size() || positions[ count ] != p) {
+             return false;
+          }
+          ++count;
+       }
+       return count == positions.size();
+    }
+
+    /**
+     * Индексы стертых символов принятого вектора.
+     */
+    std::vector< int > FindErased( const CodeWord< T, M >& v ) const
+    {
+       std::vector< int > ids;
+       for( int i = 0; i < static_cast< int >( v.size() ); ++i )
+       {
+          if( v[ i ].mStatus == SymbolStatus::Erased )
+             ids.push_back( i );
+       }
+       return ids;
+    }
+
+    /**
+     * Собрать индексы стертых символов (систематический порядок) в рабочую область; сохраняется не более R + 1 индексов.
+     * @param is_erased - признак стирания символа систематического кода с индексом j.
+     * Возвращает полное количество стертых символов.
+     */
+    template< typename Predicate >
+    int CollectErased( DecodeWorkspace& workspace, Predicate is_erased ) const
+    {
+       workspace.mErased.clear();
+       int erased = 0;
+       for( int j = 0; j < N; ++j )
+       {
+          if( !is_erased( j ) )
+             continue;
+          if( erased++ <= R )
+             workspace.mErased.push_back( j );
+       }
+       return erased;
+    }
+
+    /**
+     * Собрать стертые символы в workspace.mErased и найти номер k символа в позиции position среди них
+     * (-1, если символ не стерт). Возвращает false, если стертых символов больше R.
+     */
+    bool FindErasedSlot( std::span< const std::uint64_t > erasures, int position, DecodeWorkspace& workspace,
+                         int& k ) const
+    {
+       assert( std::cmp_greater_equal( erasures.size() * 64, N ) && position >= 0 && position < N );
+       k = -1;
+       if (( ( erasures[ position / 64 ] >> ( position % 64 ) ) & 1 ) == 0) {
+          return true;
+       }
+       const int erased = CollectErased( workspace, [this, erasures]( int j ) {
+          const int p = Position( j );
+          return ( ( erasures[ p / 64 ] >> ( p % 64 ) ) & 1 ) != 0;
+       } );
+       if (erased > R) {
+          return false;
+       }
+       const int id = SystematicIndex( position );
+       k = std::lower_bound( workspace.mErased.begin(), workspace.mErased.end(), id ) - workspace.mErased.begin();
+       return true;
+    }
+
+    /**
+     * Количество стертых символов в битовой карте стираний (учитываются позиции 0..N-1).
+     */
+    int CountErasures( std::span< const std::uint64_t > erasures ) const
+    {
+       int count = 0;
+       for( int w = 0; w < ( N + 63 ) / 64; ++w )
+       {
+          const int tail = N - w * 64;
+          const std::uint64_t mask = tail >= 64 ? ~std::uint64_t( 0 ) : ( std::uint64_t( 1 ) << tail ) - 1;
+          count += std::popcount( erasures[ w ] & mask );
+       }
+       return count;
+    }
+
+    /**
+     * Отчет о полосе stripe по битовой карте строк с ненулевым синдромом.
+     */
+    VerifyFailure MakeVerifyFailure( std::size_t stripe, std::span< const std::uint64_t > rows ) const
+    {
+       VerifyFailure failure{ .mStripe = stripe, .mRows = {} };
+       for( int i = 0; i < R; ++i )
+          if( ( rows[ i / 64 ] >> ( i % 64 ) ) & 1 )
+             failure.mRows.push_back( i );
+       return failure;
+    }
+
+    /**
+     * Записать в symbol сумму символов sources (индексы в систематическом порядке); пустая сумма - нули.
+     */
+    void XorSources( std::byte* symbol, std::span< const int > sources, std::span< std::byte* const > codeword,
+                     std::size_t bytes ) const
+    {
+       if (sources.empty()) {
+          std::memset( symbol, 0, bytes );
+          return;
+       }
+       AddMetric( Metric::XorBytes, ( sources.size() - 1 ) * bytes );
+       std::memcpy( symbol, codeword[ Position( sources[ 0 ] ) ], bytes );
+       for (std::size_t s = 1; s < sources.size(); ++s) {
+          XorInto( symbol, codeword[ Position( sources[ s ] ) ], bytes );
+       }
+    }
+
+    /**
+     * Привести принятый вектор к порядку символов систематического кода (для несистематического режима).
+     */
+    void ToSystematicOrder( CodeWord< T, M >& v ) const
+    {
+       if (!mIsSystematic) {
+          for (const auto& [a, b] : mSwaps) {
+             std::swap( v[ a ], v[ b ] );
+          }
+       }
+    }
+
+    /**
+     * План восстановления для набора стертых символов (систематический порядок): из кэша либо построенный заново.
+     */
+    std::shared_ptr< const RecoveryPlan > GetRecoveryPlan( const std::vector< int >& erased_ids )
+    {
+       bool is_built;
+       return GetRecoveryPlan( erased_ids, is_built );
+    }
+
+    /**
+     * То же; is_built - план построен заново (его не было в кэше).
+     */
+    std::shared_ptr< const RecoveryPlan > GetRecoveryPlan( const std::vector< int >& erased_ids, bool& is_built )
+    {
+       auto plan = mRecoveryCache.Find( erased_ids );
+       is_built = !plan;
+       if( !plan )
+       {
+          auto built = mUsePeeling ? MakePeelingPlan( mHsparse, mHsys, erased_ids ) : MakeRecoveryPlan( mHsys, erased_ids );
+          OptimizeRecoveryPlan( built );
+          plan = std::make_shared< const RecoveryPlan >( std::move( built ) );
+          mRecoveryCache.Insert( plan );
+          AddMetric( Metric::PlansBuilt );
+       }
+       else
+       {
+          AddMetric( Metric::PlanCacheHits );
+       }
+       return plan;
+    }
+
+    /**
+     * Восстановить стертые символы по плану в буферах, заданных указателями (порядок кодового слова).
+     * @param offset - начало обрабатываемого диапазона [offset, offset + bytes) в каждом символе.
+     */
+    void ApplyRecoveryPlan( const RecoveryPlan& plan, std::span< std::byte* const > codeword, std::size_t bytes,
+                            std::size_t offset = 0 ) const
+    {
+       if constexpr( kMetricsEnabled )
+          AddMetric( Metric::XorBytes, static_cast< std::uint64_t >( plan.XorCount() ) * bytes );
+       if( !plan.mSchedule.Empty() )
+       {
+          ApplyXorSchedule( plan.mSchedule,
+                            [this, codeword, offset]( int j ) -> const std::byte* {
+                               return codeword[ Position( j ) ] + offset;
+                            },
+                            [this, codeword, offset, &plan]( int i ) {
+                               return codeword[ Position( plan.mErased[ plan.mScheduled[ i ] ] ) ] + offset;
+                            }, bytes );
+          return;
+       }
+       const int steps = plan.mOrder.empty() ? plan.mErased.size() : plan.mOrder.size();
+       for( int step = 0; step < steps; ++step )
+       {
+          const int k = plan.mOrder.empty() ? step : plan.mOrder[ step ];
+          if( !plan.mIsRecoverable[ k ] )
+             continue;
+          std::byte* symbol = codeword[ Position( plan.mErased[ k ] ) ] + offset;
+          const int first = plan.mOffsets[ k ];
+          const int last = plan.mOffsets[ k + 1 ];
+          if( first == last )
+          {
+             std::memset( symbol, 0, bytes );
+             continue;
+          }
+          std::memcpy( symbol, codeword[ Position( plan.mSources[ first ] ) ] + offset, bytes );
+          for( int s = first + 1; s < last; ++s )
+             XorInto( symbol, codeword[ Position( plan.mSources[ s ] ) ] + offset, bytes );
+       }
+    }
+
+    /**
+     * Восстановить стертые символы по плану: только XOR нестертых символов, без исключения Гаусса.
+     * Невосстановимые символы остаются стертыми.
+     */
+    void ApplyRecoveryPlan( const RecoveryPlan& plan, CodeWord< T, M >& v ) const
+    {
+       if constexpr( kMetricsEnabled )
+          AddMetric( Metric::XorBytes, static_cast< std::uint64_t >( plan.XorCount() ) * kSymbolBytes );
+       if( !plan.mSchedule.Empty() )
+       {
+          ApplyXorSchedule( plan.mSchedule,
+                            [&v]( int j ) { return reinterpret_cast< const std::byte* >( v[ j ].mSymbol.data() ); },
+                            [&v, &plan]( int i ) {
+                               auto& element = v[ plan.mErased[ plan.mScheduled[ i ] ] ];
+                               element.mStatus = SymbolStatus::Normal;
+                               return reinterpret_cast< std::byte* >( element.mSymbol.data() );
+                            }, kSymbolBytes );
+          return;
+       }
+       const int steps = plan.mOrder.empty() ? plan.mErased.size() : plan.mOrder.size();
+       for( int step = 0; step < steps; ++step )
+       {
+          const int k = plan.mOrder.empty() ? step : plan.mOrder[ step ];
+          if( !plan.mIsRecoverable[ k ] )
+             continue;
+          auto& element = v[ plan.mErased[ k ] ];
+          element = { .mStatus = SymbolStatus::Normal, .mSymbol = {} };
+          for( int s = plan.mOffsets[ k ]; s < plan.mOffsets[ k + 1 ]; ++s )
+             element += v[ plan.mSources[ s ] ];
+       }
+    }
+
+    /**
+     * Загрузить матрицы встроенного кода из таблиц, вычисленных на этапе компиляции.
+     */
+    void LoadStaticTables()
+    {
+       constexpr auto& tables = kExtendedHammingTables< R >;
+       static_assert( tables.mIsOk );
+       mH = BitMatrix( R, N );
+       mHsys = BitMatrix( R, N );
+       for( int i = 0; i < R; ++i )
+       {
+          std::copy( tables.mH[ i ].begin(), tables.mH[ i ].end(), mH.Row( i ) );
+          std::copy( tables.mHsys[ i ].begin(), tables.mHsys[ i ].end(), mHsys.Row( i ) );
+       }
+       mSwaps.assign( tables.mSwaps.begin(), tables.mSwaps.begin() + tables.mSwapCount );
+    }
+
+    /**
+     * 
+     */
+    auto getSwaps() const {
+      return mSwaps;
+    }
+ 
+    /**
+     * Включить/выключить режим систематического кодирования. 
+     */
+    void SwitchToSystematic(bool is_systematic) {
+       mIsSystematic = is_systematic;
+    }
+ 
+    bool mIsSystematic = true;
+
+    /**
+     * Встроенный расширенный код Хэмминга (внешняя матрица не задана).
+     */
+    bool mIsBuiltin = true;
+ 
+    /**
+     * Сделанные во время формирования систематической матрицы перестановки столбцов. 
+     */
+    Swaps< int > mSwaps;
+
+    /**
+     * Позиции символов систематического кода в кодовом слове несистематического кода
+     * (перестановки mSwaps, примененные по порядку).
+     */
+    std::vector< int > mPositions;
+
+    /**
+     * Обратная перестановка: индекс символа систематического кода в позиции p кодового слова.
+     */
+    std::vector< int > mIndices;
+
+    /**
+     * Индексы стертых символов: переиспользуемый буфер DecodeSymbols.
+     */
+    std::vector< int > mErasedIds;
+
+    /**
+     * Рабочая область DecodeSymbol без рабочей области вызывающей стороны (создается при первом вызове).
+     */
+    std::optional< DecodeWorkspace > mSymbolWorkspace;
+ 
+    /**
+     * Проверочная матрица кода (несистематическая).
+     */
+    BitMatrix mH;
+ 
+    /**
+     * Проверочная матрица систематического кода.
+     */
+    BitMatrix mHsys;
+
+    /**
+     * Разреженная проверочная матрица (столбцы в систематическом порядке) для декодирования выщипыванием.
+     */
+    SparseMatrix mHsparse;
+
+    /**
+     * Столбцы mHsys в 64-битных словах (при R <= kMaxMaskR) для проверки восстановимости без данных.
+     */
+    std::vector< std::uint64_t > mColumnMasks;
+
+    /**
+     * Таблица синдром -> столбец mHsys для исправления одной ошибки (при R <= kMaxSyndromeTableR).
+     */
+    std::vector< int > mSyndromeTable;
+
+    /**
+     * Стертые символы восстанавливаются выщипыванием по mHsparse (для разреженных матриц, например LDPC).
      */
-    Matrix< int > mHsys;
+    bool mUsePeeling = false;
 
     /**
-     * Выборочная матрица, соответствующая столбцам со стираниями.
+     * Расписание XOR кодирования (проверочный символ i - выход i) для кодов без таблиц этапа компиляции.
      */
-    Matrix< int > mErasureSubmatrix;
+    XorSchedule mEncodeSchedule;
 
     /**
-     * Столбец свободных членов.
+     * Кэш планов восстановления: повторяющиеся наборы стираний декодируются без исключения Гаусса.
+     * Счетчики попаданий/промахов - mRecoveryCache.Hits(), mRecoveryCache.Misses().
      */
-    CodeWord<T, M> mFreeColumn;
+    RecoveryCache mRecoveryCache;
  };
  
  template <typename T, int M>
@@ -0,0 +1,362 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm> // std::min, std::max
+ #include <array>   // std::array
+ #include <bit>     // std::bit_width, std::has_single_bit, std::countr_zero
+ #include <cassert> // assert
+ #include <cstddef> // std::byte, std::size_t
+ #include <cstdint> // std::uint64_t
+ #include <cstring> // std::memcpy, std::memset
+ #include <span>    // std::span
+ #include <utility> // std::swap
+ #include <vector>  // std::vector
+
+ #include "hamming.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * Встроенный расширенный код Хэмминга без плотных матриц: столбец p проверочной матрицы - единица
+  * в первой строке и двоичные разряды номера (p + 1), поэтому синдром и система для стертых символов
+  * вычисляются по битам индексов. Память кода O(R) вместо O(R * N), что позволяет R до 20 и более.
+  * Систематический порядок свой (не совпадает с HammingExtended): информационные символы - столбцы,
+  * у которых (p + 1) не степень двойки, по возрастанию; проверочный символ i < R - 1 - столбец p = 2^i - 1,
+  * проверочный символ R - 1 - последний столбец.
+  * R - количество проверочных символов, M - векторность, T - тип внутреннего символа.
+  */
+ template< typename T, int R, int M >
+ struct ImplicitHammingExtended
+ {
+    static_assert( R >= 3 && R <= 30, "Gauss elimination packs R x (e + R) bits into 64-bit words" );
+
+    static constexpr int N = power2< int >( R - 1 );
+
+    static constexpr int K = N - R;
+
+    static constexpr int D = 4;
+
+    static constexpr std::size_t kSymbolBytes = sizeof( T ) * M;
+
+    /**
+     * Столбец p (естественный порядок) проверочной матрицы: бит 0 - строка из единиц,
+     * бит 1 + b - разряд b номера (p + 1) (старший разряд номера последнего столбца не учитывается).
+     */
+    static constexpr std::uint64_t Column( int p )
+    {
+       return 1 | ( static_cast< std::uint64_t >( ( p + 1 ) & ( N - 1 ) ) << 1 );
+    }
+
+    /**
+     * Индекс систематического кода для столбца p естественного порядка.
+     */
+    static constexpr int SystematicIndexOf( int p )
+    {
+       const unsigned u = p + 1;
+       if( u == unsigned( N ) )
+          return N - 1;
+       if( std::has_single_bit( u ) )
+          return K + std::countr_zero( u );
+       return u - std::bit_width( u ) - 1;
+    }
+
+    /**
+     * Столбец естественного порядка для индекса j систематического кода (обратное к SystematicIndexOf).
+     */
+    static constexpr int NaturalPosition( int j )
+    {
+       if( j >= K )
+          return j - K < R - 1 ? power2< int >( j - K ) - 1 : N - 1;
+       // Среди 1..u ровно u - bit_width(u) чисел, не являющихся степенью двойки.
+       unsigned w = std::bit_width( unsigned( j + 1 ) );
+       unsigned u = j + 1 + w;
+       while( std::bit_width( u ) != w )
+       {
+          w = std::bit_width( u );
+          u = j + 1 + w;
+       }
+       return ( std::has_single_bit( u ) ? u - 1 : u ) - 1;
+    }
+
+    /**
+     * Позиция символа систематического кода с индексом j в кодовом слове (с учетом режима кодирования).
+     */
+    int Position( int j ) const
+    {
+       return mIsSystematic ? j : NaturalPosition( j );
+    }
+
+    /**
+     * Позиция в кодовом слове столбца p естественного порядка.
+     */
+    int PositionOf( int p ) const
+    {
+       return mIsSystematic ? SystematicIndexOf( p ) : p;
+    }
+
+    void SwitchToSystematic( bool is_systematic )
+    {
+       mIsSystematic = is_systematic;
+    }
+
+    /**
+     * Закодировать информационный вектор.
+     */
+    CodeWord< T, M > Encode( const CodeWord< T, M >& a ) const
+    {
+       assert( std::cmp_equal( a.size(), K ) );
+       CodeWord< T, M > result( N, CodeElement< T, M >{ .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+       for( int k = 0; k < K; ++k )
+       {
+          assert( a[ k ].mStatus == SymbolStatus::Normal );
+          result[ Position( k ) ] = a[ k ];
+       }
+       EncodeSymbols( Pointers( result ), kSymbolBytes );
+       return result;
+    }
+
+    /**
+     * Закодировать кодовое слово, заданное указателями на символы (см. HammingExtended::EncodeSymbols).
+     * Проверочный символ разряда b - сумма информационных символов, у которых в номере есть разряд b;
+     * последний проверочный символ дополняет сумму всех символов до нуля.
+     */
+    void EncodeSymbols( std::span< std::byte* const > codeword, std::size_t bytes ) const
+    {
+       assert( std::cmp_equal( codeword.size(), N ) );
+       std::array< std::byte*, R > parity;
+       for( int i = 0; i < R - 1; ++i )
+          parity[ 1 + i ] = codeword[ PositionOf( power2< int >( i ) - 1 ) ];
+       parity[ 0 ] = codeword[ PositionOf( N - 1 ) ];
+       for( auto* symbol : parity )
+          std::memset( symbol, 0, bytes );
+       for( int p = 0; p < N - 1; ++p )
+       {
+          if( std::has_single_bit( unsigned( p + 1 ) ) )
+             continue;
+          const std::byte* symbol = codeword[ PositionOf( p ) ];
+          for( auto column = Column( p ); column != 0; column &= column - 1 )
+             XorInto( parity[ std::countr_zero( column ) ], symbol, bytes );
+       }
+       for( int i = 1; i < R; ++i )
+          XorInto( parity[ 0 ], parity[ i ], bytes );
+    }
+
+    /**
+     * Решение системы для набора стертых символов: стертый символ k равен сумме компонент синдрома
+     * нестертых символов, отмеченных в mCombination[ k ] (0 - символ не определяется однозначно).
+     */
+    struct Plan
+    {
+       /**
+        * Стертые столбцы (естественный порядок) - не более R.
+        */
+       std::array< int, R > mIds{};
+
+       int mErased = 0;
+
+       std::array< std::uint64_t, R > mCombination{};
+
+       /**
+        * Объединение mCombination: компоненты синдрома, которые нужно вычислить.
+        */
+       std::uint64_t mNeeded = 0;
+
+       /**
+        * Все стертые информационные символы восстановимы.
+        */
+       bool mIsOk = true;
+    };
+
+    /**
+     * Построить решение для битовой карты стираний (бит q - символ в позиции q кодового слова).
+     * Система (R x e) строится по битам номеров стертых столбцов и решается методом Гаусса-Жордана
+     * в 64-битных словах; память не выделяется.
+     */
+    Plan MakePlan( std::span< const std::uint64_t > erasures ) const
+    {
+       assert( std::cmp_greater_equal( erasures.size() * 64, N ) );
+       Plan plan;
+       for( int w = 0; w < ( N + 63 ) / 64; ++w )
+       {
+          for( auto word = erasures[ w ]; word != 0; word &= word - 1 )
+          {
+             const int q = w * 64 + std::countr_zero( word );
+             if( q >= N )
+                break;
+             if( plan.mErased < R )
+                plan.mIds[ plan.mErased ] = mIsSystematic ? NaturalPosition( q ) : q;
+             ++plan.mErased;
+          }
+       }
+       const int e = plan.mErased;
+       if( e > R )
+       {
+          plan.mIsOk = false;
+          return plan;
+       }
+       // Расширенная матрица [ A | E ]: A - столбцы стертых символов, E - единичная (учет комбинаций строк).
+       std::array< std::uint64_t, R > rows;
+       for( int i = 0; i < R; ++i )
+       {
+          rows[ i ] = std::uint64_t( 1 ) << ( e + i );
+          for( int k = 0; k < e; ++k )
+             rows[ i ] |= ( ( Column( plan.mIds[ k ] ) >> i ) & 1 ) << k;
+       }
+       std::array< int, R > pivot_row;
+       pivot_row.fill( -1 );
+       for( int k = 0, rank = 0; k < e && rank < R; ++k )
+       {
+          int where_unit = rank;
+          while( where_unit < R && ( ( rows[ where_unit ] >> k ) & 1 ) == 0 )
+             ++where_unit;
+          if( where_unit == R )
+             continue;
+          std::swap( rows[ where_unit ], rows[ rank ] );
+          for( int i = 0; i < R; ++i )
+             if( i != rank && ( ( rows[ i ] >> k ) & 1 ) )
+                rows[ i ] ^= rows[ rank ];
+          pivot_row[ k ] = rank++;
+       }
+       const std::uint64_t erased_mask = ( std::uint64_t( 1 ) << e ) - 1;
+       for( int k = 0; k < e; ++k )
+       {
+          const int row = pivot_row[ k ];
+          if( row != -1 && ( rows[ row ] & erased_mask & ~( std::uint64_t( 1 ) << k ) ) == 0 )
+          {
+             plan.mCombination[ k ] = rows[ row ] >> e;
+             plan.mNeeded |= plan.mCombination[ k ];
+          }
+          else if( SystematicIndexOf( plan.mIds[ k ] ) < K )
+          {
+             plan.mIsOk = false;
+          }
+       }
+       return plan;
+    }
+
+    /**
+     * Восстановить символы по решению: вычисляются только нужные компоненты синдрома нестертых символов,
+     * порциями в буфере потока.
+     */
+    void ApplyPlan( const Plan& plan, std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                    std::size_t bytes ) const
+    {
+       if( plan.mNeeded == 0 )
+          return;
+       const std::size_t chunk = std::min( bytes, std::max< std::size_t >( 1024, 256 * 1024 / R / 64 * 64 ) );
+       std::byte* syndrome = XorScratch( R * chunk );
+       for( std::size_t offset = 0; offset < bytes; offset += chunk )
+       {
+          const std::size_t n = std::min( chunk, bytes - offset );
+          for( int i = 0; i < R; ++i )
+             if( ( plan.mNeeded >> i ) & 1 )
+                std::memset( syndrome + i * chunk, 0, n );
+          for( int p = 0; p < N; ++p )
+          {
+             const int q = PositionOf( p );
+             if( ( erasures[ q / 64 ] >> ( q % 64 ) ) & 1 )
+                continue;
+             const std::byte* symbol = codeword[ q ] + offset;
+             for( auto column = Column( p ) & plan.mNeeded; column != 0; column &= column - 1 )
+                XorInto( syndrome + std::countr_zero( column ) * chunk, symbol, n );
+          }
+          for( int k = 0; k < plan.mErased; ++k )
+          {
+             auto rest = plan.mCombination[ k ];
+             if( rest == 0 )
+                continue;
+             std::byte* symbol = codeword[ PositionOf( plan.mIds[ k ] ) ] + offset;
+             std::memcpy( symbol, syndrome + std::countr_zero( rest ) * chunk, n );
+             for( rest &= rest - 1; rest != 0; rest &= rest - 1 )
+                XorInto( symbol, syndrome + std::countr_zero( rest ) * chunk, n );
+          }
+       }
+    }
+
+    /**
+     * Восстановить стертые символы по месту (параметры - как у HammingExtended::DecodeSymbols).
+     * Не меняет объект кода и не выделяет память (кроме роста буфера потока): один код можно
+     * использовать из многих потоков.
+     */
+    bool DecodeSymbols( std::span< std::byte* const > codeword, std::span< const std::uint64_t > erasures,
+                        std::size_t bytes, int& erased ) const
+    {
+       assert( std::cmp_equal( codeword.size(), N ) );
+       const auto plan = MakePlan( erasures );
+       erased = plan.mErased;
+       if (erased > R) {
+          return false;
+       }
+       ApplyPlan( plan, codeword, erasures, bytes );
+       return plan.mIsOk;
+    }
+
+    /**
+     * Декодировать принятый вектор в режиме стирания ошибки. После декодирования dim(v) = K.
+     * Возвращает false, если стертых символов больше R или какой-либо стертый информационный символ
+     * не определяется однозначно.
+     */
+    bool Decode( CodeWord< T, M >& v, int& erased ) const
+    {
+       assert( std::cmp_equal( v.size(), N ) && "Input size is wrong" );
+       std::vector< std::uint64_t > erasures( ( N + 63 ) / 64 );
+       for( int q = 0; q < N; ++q )
+          if( v[ q ].mStatus == SymbolStatus::Erased )
+             erasures[ q / 64 ] |= std::uint64_t( 1 ) << ( q % 64 );
+       const auto plan = MakePlan( erasures );
+       erased = plan.mErased;
+       if (erased > R) {
+          return false;
+       }
+       ApplyPlan( plan, Pointers( v ), erasures, kSymbolBytes );
+       for( int k = 0; k < erased; ++k )
+          if( plan.mCombination[ k ] != 0 )
+             v[ PositionOf( plan.mIds[ k ] ) ].mStatus = SymbolStatus::Normal;
+       if( !mIsSystematic )
+       {
+          CodeWord< T, M > info( K );
+          for( int k = 0; k < K; ++k )
+             info[ k ] = v[ NaturalPosition( k ) ];
+          v = std::move( info );
+       }
+       v.resize( K );
+       return plan.mIsOk;
+    }
+
+    /**
+     * Вычислить синдром по принятому вектору (без стираний); строки - строки несистематической матрицы.
+     */
+    CodeWord< T, M > CalcSyndrome( const CodeWord< T, M >& v ) const
+    {
+       assert( std::cmp_equal( v.size(), N ) );
+       CodeWord< T, M > result( R, CodeElement< T, M >{ .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+       for( int p = 0; p < N; ++p )
+       {
+          const auto& element = v[ PositionOf( p ) ];
+          // Бит 1 + b столбца - строка R - 1 - b матрицы MakeExtendedHammingMatrix.
+          for( auto column = Column( p ); column != 0; column &= column - 1 )
+          {
+             const int bit = std::countr_zero( column );
+             result[ bit == 0 ? 0 : R - bit ] += element;
+          }
+       }
+       return result;
+    }
+
+    bool mIsSystematic = true;
+
+ private:
+    static std::vector< std::byte* > Pointers( CodeWord< T, M >& v )
+    {
+       std::vector< std::byte* > symbols( v.size() );
+       for( std::size_t j = 0; j < v.size(); ++j )
+          symbols[ j ] = reinterpret_cast< std::byte* >( v[ j ].mSymbol.data() );
+       return symbols;
+    }
+ };
+
+ } // namespace hamming
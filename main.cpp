@@ -1,5 +1,14 @@
-#include <iostream> // std::cout
+#include <algorithm>  // std::shuffle
+#include <cstdio>     // std::remove
+#include <filesystem> // std::filesystem::temp_directory_path
+#include <iostream>   // std::cout
+#include <random>     // std::mt19937
+#include <vector>     // std::vector
 #include "hamming.hpp"
+#include "implicit_hamming.hpp"
+#include "product_code.hpp"
+#include "stream_encoder.hpp"
+#include "thread_pool.hpp"
 
 
 static void TestHamming()
@@ -12,6 +21,8 @@ static void TestHamming()
    code.SwitchToSystematic(true); // Cистематический код.
    // code.SwitchToSystematic(false); // Несистематический код.
    std::cout << "K: " << code.K << ", N: " << code.N << '\n';    
+   const auto [encode_xors, naive_encode_xors] = code.EncodeXorCount();
+   std::cout << "Encode XORs per codeword: " << encode_xors << " (naive: " << naive_encode_xors << ")\n";
    show_matrix(code.mH, "Parity check matrix H:");
    show_matrix(code.mHsys, "Parity check matrix in systematic form H:");
    // Формирование некоторого информационного вектора.
@@ -46,8 +57,383 @@ static void TestHamming()
    std::cout << '\n';
 }
 
+/**
+ * Декодирование с исправлением ошибок: одна ошибка без стираний и с одним стиранием исправляется,
+ * двойная ошибка обнаруживается без изменения символов. При R <= 16 символ без стираний находится по таблице
+ * синдромов, при большем R и при стираниях - перебором приведенных столбцов.
+ */
+template< int R >
+static bool TestErrorCorrection()
+{
+   using namespace hamming;
+   constexpr int M = 4;
+   HammingExtended< uint8_t, R, M > code;
+   code.SwitchToSystematic(false); // Позиции символов не совпадают с систематическим порядком.
+   const int N = code.N;
+   const std::size_t bytes = code.kSymbolBytes;
+   std::vector< std::byte > buffer( N * bytes );
+   std::vector< std::byte* > codeword( N );
+   for( int p = 0; p < N; ++p )
+   {
+      codeword[ p ] = buffer.data() + p * bytes;
+      for( std::size_t b = 0; b < bytes; ++b )
+         codeword[ p ][ b ] = std::byte( p * 7 + b * 13 + 1 );
+   }
+   code.EncodeSymbols( codeword, bytes );
+   const auto reference = buffer;
+   std::vector< std::uint64_t > erasures( ( N + 63 ) / 64 );
+   int erased, corrected;
+   bool is_ok = true;
+   // Одна ошибка без стираний.
+   codeword[ 3 ][ 1 ] ^= std::byte{ 0x5a };
+   is_ok &= code.DecodeErrors( codeword, erasures, bytes, erased, corrected ) && corrected == 1 && buffer == reference;
+   // Одна ошибка и одно стирание: 2 + 1 < D = 4.
+   const int lost = N / 2;
+   std::fill( codeword[ lost ], codeword[ lost ] + bytes, std::byte{ 0xff } );
+   erasures[ lost / 64 ] |= std::uint64_t( 1 ) << ( lost % 64 );
+   codeword[ N - 1 ][ 0 ] ^= std::byte{ 0x81 };
+   is_ok &= code.DecodeErrors( codeword, erasures, bytes, erased, corrected ) && erased == 1 && corrected == 1 &&
+            buffer == reference;
+   // Две ошибки: обнаруживаются, символы не изменяются.
+   erasures[ lost / 64 ] = 0;
+   codeword[ 0 ][ 2 ] ^= std::byte{ 0x11 };
+   codeword[ N - 2 ][ 3 ] ^= std::byte{ 0x40 };
+   const auto corrupted = buffer;
+   is_ok &= !code.DecodeErrors( codeword, erasures, bytes, erased, corrected ) && corrected == 0 &&
+            buffer == corrupted;
+   // Длинные символы проверяются порциями kVerifyChunkBytes: ошибка в нескольких порциях одного символа
+   // исправляется, ошибки разных символов в разных порциях обнаруживаются.
+   const std::size_t long_bytes = 2 * kVerifyChunkBytes + 100;
+   std::vector< std::byte > long_buffer( N * long_bytes );
+   std::vector< std::byte* > long_codeword( N );
+   for( int p = 0; p < N; ++p )
+   {
+      long_codeword[ p ] = long_buffer.data() + p * long_bytes;
+      for( std::size_t b = 0; b < long_bytes; ++b )
+         long_codeword[ p ][ b ] = std::byte( p * 5 + b * 3 + 2 );
+   }
+   code.EncodeSymbols( long_codeword, long_bytes );
+   const auto long_reference = long_buffer;
+   erasures.assign( erasures.size(), 0 );
+   long_codeword[ 2 ][ 10 ] ^= std::byte{ 0x03 };
+   long_codeword[ 2 ][ long_bytes - 1 ] ^= std::byte{ 0x70 };
+   is_ok &= code.DecodeErrors( long_codeword, erasures, long_bytes, erased, corrected ) && corrected == 1 &&
+            long_buffer == long_reference;
+   long_codeword[ N - 1 ][ kVerifyChunkBytes + 7 ] ^= std::byte{ 0x09 };
+   is_ok &= code.DecodeErrors( long_codeword, erasures, long_bytes, erased, corrected ) && corrected == 1 &&
+            long_buffer == long_reference;
+   long_codeword[ 1 ][ 0 ] ^= std::byte{ 0x20 };
+   long_codeword[ 4 ][ long_bytes - 2 ] ^= std::byte{ 0x20 };
+   const auto long_corrupted = long_buffer;
+   is_ok &= !code.DecodeErrors( long_codeword, erasures, long_bytes, erased, corrected ) && corrected == 0 &&
+            long_buffer == long_corrupted;
+   // Вариант для кодового слова: одна ошибка и одно стирание.
+   CodeWord< uint8_t, M > a( code.K, { .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+   for( uint8_t i = 0; auto& el : a )
+      el.mSymbol = { i++, i++, i++, i++ };
+   auto v = code.Encode( a );
+   v[ 1 ].mSymbol[ 0 ] ^= 0x24;
+   v[ N - 3 ] = { .mStatus = SymbolStatus::Erased, .mSymbol = {} };
+   is_ok &= code.DecodeErrors( v, erased, corrected ) && corrected == 1 && v == a;
+   std::cout << "Error correction (R = " << R << "): " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+
+/**
+ * Потоковое кодирование: информационные символы поступают в случайном порядке (несистематический код),
+ * проверочные символы совпадают с EncodeSymbols. Add отклоняет повтор символа, проверочную позицию
+ * и новую полосу при занятых накопителях.
+ */
+static bool TestStreamEncoder()
+{
+   using namespace hamming;
+   constexpr int R = 5;
+   constexpr int M = 4;
+   HammingExtended< uint8_t, R, M > code;
+   code.SwitchToSystematic(false);
+   const int N = code.N;
+   const std::size_t bytes = 64;
+   std::vector< std::byte > expected( N * bytes ), streamed( N * bytes );
+   std::vector< std::byte* > expected_codeword( N ), streamed_codeword( N );
+   std::vector< int > info;
+   for( int p = 0; p < N; ++p )
+   {
+      expected_codeword[ p ] = expected.data() + p * bytes;
+      streamed_codeword[ p ] = streamed.data() + p * bytes;
+      for( std::size_t b = 0; b < bytes; ++b )
+         expected_codeword[ p ][ b ] = std::byte( p * 11 + b * 3 + 5 );
+      if( code.SystematicIndex( p ) < code.K )
+         info.push_back( p );
+   }
+   code.EncodeSymbols( expected_codeword, bytes );
+   std::shuffle( info.begin(), info.end(), std::mt19937( 2024 ) );
+   StreamEncoder< uint8_t, R, M > encoder( code, bytes, 1 );
+   bool is_ok = true;
+   for( int p : info )
+      is_ok &= encoder.Add( 0, p, expected_codeword[ p ] );
+   is_ok &= !encoder.Add( 0, info.front(), expected_codeword[ info.front() ] ); // Повтор символа.
+   is_ok &= !encoder.Add( 0, code.Position( code.K ), expected_codeword[ info.front() ] ); // Проверочная позиция.
+   is_ok &= !encoder.Add( 1, info.front(), expected_codeword[ info.front() ] ); // Накопитель занят полосой 0.
+   is_ok &= encoder.IsComplete( 0 ) && encoder.TakeParity( 0, streamed_codeword ) && encoder.InFlight() == 0;
+   for( int i = 0; i < R; ++i )
+   {
+      const int p = code.Position( code.K + i );
+      is_ok &= std::equal( streamed_codeword[ p ], streamed_codeword[ p ] + bytes, expected_codeword[ p ] );
+   }
+   std::cout << "Stream encoder: " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+
+/**
+ * Произведение кодов: любые три строки и три столбца сетки восстанавливаются побайтно точно;
+ * при стертых ColumnR + 1 строках информационные символы остаются стертыми и декодер возвращает false.
+ */
+template< int RowR, int ColumnR >
+static bool TestProductCode( hamming::ThreadPool& pool )
+{
+   using namespace hamming;
+   constexpr int M = 4;
+   HammingExtended< uint8_t, RowR, M > row_code;
+   HammingExtended< uint8_t, ColumnR, M > column_code;
+   column_code.SwitchToSystematic(false);
+   ProductCode< uint8_t, RowR, ColumnR, M > product( row_code, column_code );
+   const int rows = product.Rows();
+   const int columns = product.Columns();
+   const std::size_t bytes = 32;
+   std::vector< std::byte > buffer( rows * columns * bytes );
+   std::vector< std::byte* > grid( rows * columns );
+   for( int cell = 0; cell < rows * columns; ++cell )
+   {
+      grid[ cell ] = buffer.data() + cell * bytes;
+      if( product.IsInformation( cell / columns, cell % columns ) )
+         for( std::size_t b = 0; b < bytes; ++b )
+            grid[ cell ][ b ] = std::byte( cell * 5 + b * 17 + 3 );
+   }
+   product.Encode( grid, bytes, pool );
+   const auto reference = buffer;
+   auto erase = [&]( auto is_erased ) {
+      std::vector< std::uint64_t > erasures( ( rows * columns + 63 ) / 64 );
+      for( int cell = 0; cell < rows * columns; ++cell )
+         if( is_erased( cell / columns, cell % columns ) )
+         {
+            erasures[ cell / 64 ] |= std::uint64_t( 1 ) << ( cell % 64 );
+            std::fill( grid[ cell ], grid[ cell ] + bytes, std::byte{ 0xee } );
+         }
+      return erasures;
+   };
+   int remaining;
+   // Три строки и три столбца.
+   auto erasures = erase( []( int r, int c ) { return r == 0 || r == 4 || r == 7 || c == 1 || c == 2 || c == 6; } );
+   bool is_ok = product.Decode( grid, erasures, bytes, remaining, pool ) && remaining == 0 && buffer == reference;
+   // ColumnR + 1 строк: в каждом столбце стертых больше ColumnR, в каждой строке стерты все символы.
+   erasures = erase( []( int r, int ) { return r <= ColumnR; } );
+   is_ok &= !product.Decode( grid, erasures, bytes, remaining, pool ) && remaining == ( ColumnR + 1 ) * columns;
+   std::cout << "Product code (row R = " << RowR << ", column R = " << ColumnR << "): " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+
+/**
+ * Двоичное описание кода: сохранение, загрузка, создание кода по описанию и кодирование;
+ * проверочные символы совпадают с исходным кодом.
+ */
+static bool TestCodeDescriptor()
+{
+   using namespace hamming;
+   constexpr int R = 5;
+   constexpr int M = 4;
+   const Matrix< int > H = { { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+                             { 0, 1, 0, 1, 1, 0, 1, 0, 1, 1 },
+                             { 0, 0, 1, 1, 0, 1, 1, 1, 0, 1 },
+                             { 1, 0, 0, 0, 1, 1, 1, 1, 1, 0 },
+                             { 0, 1, 1, 0, 0, 0, 1, 1, 1, 1 } };
+   HammingExtended< uint8_t, R, M > code( H, 3 );
+   code.SwitchToSystematic(false);
+   const auto path = ( std::filesystem::temp_directory_path() / "exhamming_descriptor_test.bin" ).string();
+   CodeDescriptor loaded;
+   bool is_ok = SaveCodeDescriptor( code.Descriptor(), path ) && LoadCodeDescriptor( path, loaded );
+   std::remove( path.c_str() );
+   if( !is_ok )
+   {
+      std::cout << "Code descriptor: Failed\n";
+      return false;
+   }
+   HammingExtended< uint8_t, R, M > restored( loaded );
+   restored.SwitchToSystematic(false);
+   const int N = code.N;
+   const std::size_t bytes = 48;
+   std::vector< std::byte > expected( N * bytes ), actual( N * bytes );
+   std::vector< std::byte* > expected_codeword( N ), actual_codeword( N );
+   for( int p = 0; p < N; ++p )
+   {
+      expected_codeword[ p ] = expected.data() + p * bytes;
+      actual_codeword[ p ] = actual.data() + p * bytes;
+      for( std::size_t b = 0; b < bytes; ++b )
+         expected_codeword[ p ][ b ] = std::byte( p * 29 + b * 7 + 11 );
+   }
+   actual = expected;
+   code.EncodeSymbols( expected_codeword, bytes );
+   restored.EncodeSymbols( actual_codeword, bytes );
+   is_ok = restored.D == code.D && !loaded.mEncodeSchedule.Empty() && actual == expected;
+   std::cout << "Code descriptor: " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+
+/**
+ * Встроенный код без плотных матриц: кодирование, стирание до трех случайных символов и декодирование
+ * восстанавливают информационный вектор в систематическом и несистематическом режимах.
+ */
+template< int R >
+static bool TestImplicitHamming()
+{
+   using namespace hamming;
+   constexpr int M = 4;
+   ImplicitHammingExtended< uint8_t, R, M > code;
+   std::mt19937 generator( R );
+   bool is_ok = true;
+   for( bool is_systematic : { true, false } )
+   {
+      code.SwitchToSystematic( is_systematic );
+      for( int trial = 0; trial < 20; ++trial )
+      {
+         CodeWord< uint8_t, M > a( code.K, { .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+         for( auto& el : a )
+            for( auto& value : el.mSymbol )
+               value = generator();
+         auto v = code.Encode( a );
+         const int count = trial % 4;
+         for( int e = 0; e < count; ++e )
+            v[ generator() % code.N ] = { .mStatus = SymbolStatus::Erased, .mSymbol = {} };
+         int erased;
+         is_ok &= code.Decode( v, erased ) && erased <= count && v == a;
+      }
+   }
+   std::cout << "Implicit Hamming (R = " << R << "): " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+
+/**
+ * Проверка целостности полос: чистый набор проходит проверку, один измененный байт во второй порции символа
+ * дает ровно эту полосу со строками mHsys, содержащими символ; результат в пуле потоков совпадает с последовательным.
+ */
+static bool TestVerify( hamming::ThreadPool& pool )
+{
+   using namespace hamming;
+   constexpr int R = 5;
+   constexpr int M = 4;
+   HammingExtended< uint8_t, R, M > code;
+   code.SwitchToSystematic(false);
+   const int N = code.N;
+   const std::size_t bytes = 2 * kVerifyChunkBytes + 16;
+   const std::size_t count = 40;
+   std::vector< std::byte > buffer( count * N * bytes );
+   std::vector< std::byte* > pointers( count * N );
+   std::vector< std::span< std::byte* const > > stripes;
+   for( std::size_t s = 0; s < count; ++s )
+   {
+      for( int p = 0; p < N; ++p )
+      {
+         std::byte* symbol = buffer.data() + ( s * N + p ) * bytes;
+         pointers[ s * N + p ] = symbol;
+         for( std::size_t b = 0; b < bytes; ++b )
+            symbol[ b ] = std::byte( s * 3 + p * 17 + b );
+      }
+      stripes.push_back( std::span( pointers ).subspan( s * N, N ) );
+      code.EncodeSymbols( stripes.back(), bytes );
+   }
+   bool is_ok = code.VerifyStripes( stripes, bytes ).empty() && code.VerifyStripes( stripes, bytes, pool ).empty();
+   const std::size_t bad_stripe = 23;
+   const int bad_position = 6;
+   stripes[ bad_stripe ][ bad_position ][ kVerifyChunkBytes + 5 ] ^= std::byte{ 0x10 };
+   std::vector< int > rows;
+   for( int i = 0; i < R; ++i )
+      if( code.mHsys.Get( i, code.SystematicIndex( bad_position ) ) )
+         rows.push_back( i );
+   const auto failures = code.VerifyStripes( stripes, bytes );
+   const auto parallel_failures = code.VerifyStripes( stripes, bytes, pool );
+   is_ok &= failures.size() == 1 && failures[ 0 ].mStripe == bad_stripe && failures[ 0 ].mRows == rows &&
+            parallel_failures.size() == 1 && parallel_failures[ 0 ].mStripe == bad_stripe &&
+            parallel_failures[ 0 ].mRows == rows;
+   is_ok &= !code.VerifySymbols( stripes[ bad_stripe ], bytes ) && code.VerifySymbols( stripes[ 0 ], bytes );
+   std::cout << "Verify stripes: " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+
+#if HAMMING_METRICS
+/**
+ * Метрики декодера: план строится при первом декодировании набора стираний и берется из кэша при втором;
+ * отказ DecodeSymbol при R + 2 стертых учитывается в корзине R + 2.
+ */
+static bool TestMetrics()
+{
+   using namespace hamming;
+   constexpr int R = 5;
+   constexpr int M = 4;
+   HammingExtended< uint8_t, R, M > code;
+   const int N = code.N;
+   CodeWord< uint8_t, M > a( code.K, { .mStatus = SymbolStatus::Normal, .mSymbol = {} } );
+   for( uint8_t i = 0; auto& el : a )
+      el.mSymbol = { i++, i++, i++, i++ };
+   ResetMetrics();
+   int erased, was_changed_strategy;
+   bool is_ok = true;
+   for( int pass = 0; pass < 2; ++pass )
+   {
+      auto v = code.Encode( a );
+      v[ 2 ].mStatus = SymbolStatus::Erased;
+      v[ 7 ].mStatus = SymbolStatus::Erased;
+      is_ok &= code.Decode( v, erased, was_changed_strategy ) && v == a;
+   }
+   const std::size_t bytes = code.kSymbolBytes;
+   std::vector< std::byte > buffer( N * bytes );
+   std::vector< std::byte* > codeword( N );
+   for( int p = 0; p < N; ++p )
+      codeword[ p ] = buffer.data() + p * bytes;
+   std::vector< std::uint64_t > erasures( ( N + 63 ) / 64 );
+   for( int p = 0; p < R + 2; ++p )
+      erasures[ p / 64 ] |= std::uint64_t( 1 ) << ( p % 64 );
+   is_ok &= !code.DecodeSymbol( codeword, erasures, 0, bytes );
+   const auto snapshot = SnapshotMetrics();
+   is_ok &= snapshot.Get( Metric::DecodeCalls ) == 3 && snapshot.Get( Metric::PlansBuilt ) == 1 &&
+            snapshot.Get( Metric::PlanCacheHits ) == 1 && snapshot.Get( Metric::TooManyErasures ) == 1 &&
+            snapshot.mErasures[ 2 ] == 2 && snapshot.mErasures[ R + 2 ] == 1;
+   const auto text = snapshot.ToText();
+   is_ok &= text.find( "erasures: 2=2 7=1" ) != std::string::npos &&
+            snapshot.ToJson().find( "\"decode_calls\": 3," ) != std::string::npos;
+   std::cout << text;
+   std::cout << "Decoder metrics: " << ( is_ok ? "Ok\n" : "Failed\n" );
+   return is_ok;
+}
+#endif
+
+static void TestXorKernels()
+{
+   using namespace hamming;
+   constexpr std::size_t bytes = 4096; // Размер кодового символа, байт.
+   std::cout << "XOR kernel: " << SelectedXorKernel().mName << '\n';
+   for( const auto& kernel : AvailableXorKernels() )
+      std::cout << "  " << kernel.mName << ": " << MeasureXorBandwidth( kernel, bytes ) << " GB/s\n";
+   std::cout << '\n';
+}
+
 
 int main() {
    TestHamming();
-   return 0;
+   bool is_ok = TestErrorCorrection< 5 >();
+   is_ok &= TestErrorCorrection< 17 >();
+   is_ok &= TestStreamEncoder();
+   is_ok &= TestCodeDescriptor();
+   is_ok &= TestImplicitHamming< 4 >();
+   is_ok &= TestImplicitHamming< 5 >();
+   is_ok &= TestImplicitHamming< 9 >();
+   is_ok &= TestImplicitHamming< 14 >();
+#if HAMMING_METRICS
+   is_ok &= TestMetrics();
+#endif
+   hamming::ThreadPool pool( 2 );
+   is_ok &= TestProductCode< 4, 5 >( pool );
+   is_ok &= TestProductCode< 4, 4 >( pool );
+   is_ok &= TestVerify( pool );
+   std::cout << '\n';
+   TestXorKernels();
+   return is_ok ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,342 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm> // std::min
+ #include <array>     // std::array
+ #include <atomic>    // std::atomic
+ #include <bit>       // std::bit_width
+ #include <chrono>    // std::chrono
+ #include <cstdint>   // std::uint64_t
+ #include <cstdio>    // std::snprintf
+ #include <iterator>  // std::size
+ #include <mutex>     // std::mutex
+ #include <string>    // std::string
+ #include <vector>    // std::vector
+
+ /**
+  * Сбор метрик декодера: 1 - включен, 0 (по умолчанию) - все точки учета компилируются в пустой код.
+  */
+ #ifndef HAMMING_METRICS
+ #define HAMMING_METRICS 0
+ #endif
+
+ namespace hamming
+ {
+
+ inline constexpr bool kMetricsEnabled = HAMMING_METRICS != 0;
+
+ /**
+  * Счетчики декодера.
+  */
+ enum class Metric
+ {
+    DecodeCalls,     // Вызовы декодера (Decode, DecodeSymbols, DecodeStripes, DecodeBatch, DecodeSymbol, DecodeErrors).
+    TooManyErasures, // Отказы: стертых символов больше R.
+    Unrecoverable,   // Отказы: подматрица стертых столбцов вырождена (символ не определяется однозначно).
+    PlanCacheHits,   // Планы, взятые из кэша или рабочей области.
+    PlansBuilt,      // Построенные планы восстановления.
+    GaussPivots,     // Ведущие элементы исключения Гаусса-Жордана.
+    GaussRowOps,     // Сложения строк при исключении.
+    PeeledSymbols,   // Символы, восстановленные выщипыванием.
+    XorBytes,        // Байты, обработанные XOR при восстановлении.
+    CorrectedErrors, // Символы, исправленные по синдрому (ошибка с неизвестной позицией).
+    DetectedErrors,  // Обнаруженные неисправимые ошибки.
+    Count
+ };
+
+ inline constexpr const char* kMetricNames[] = { "decode_calls",  "too_many_erasures", "unrecoverable",
+                                                 "plan_cache_hits", "plans_built",     "gauss_pivots",
+                                                 "gauss_row_ops", "peeled_symbols",    "xor_bytes",
+                                                 "corrected_errors", "detected_errors" };
+
+ static_assert( std::size( kMetricNames ) == static_cast< std::size_t >( Metric::Count ) );
+
+ /**
+  * Гистограмма кратности стирания: 0..kMaxErasureBucket - 1, последняя корзина - kMaxErasureBucket и больше.
+  */
+ inline constexpr int kMaxErasureBucket = 64;
+
+ /**
+  * Гистограмма задержки вызова: корзина b - от 2^(b-1) до 2^b - 1 нс (корзина 0 - 0 нс).
+  */
+ inline constexpr int kLatencyBuckets = 40;
+
+ /**
+  * Сводка метрик, объединенная по всем потокам.
+  */
+ struct MetricsSnapshot
+ {
+    std::array< std::uint64_t, static_cast< std::size_t >( Metric::Count ) > mCounters{};
+
+    std::array< std::uint64_t, kMaxErasureBucket + 1 > mErasures{};
+
+    std::array< std::uint64_t, kLatencyBuckets > mLatency{};
+
+    std::uint64_t Get( Metric metric ) const { return mCounters[ static_cast< std::size_t >( metric ) ]; }
+
+    /**
+     * Оценка квантиля задержки q (0..1) по гистограмме: верхняя граница корзины, нс.
+     */
+    std::uint64_t LatencyQuantile( double q ) const
+    {
+       std::uint64_t total = 0;
+       for( auto count : mLatency )
+          total += count;
+       std::uint64_t seen = 0;
+       for( int b = 0; b < kLatencyBuckets; ++b )
+       {
+          seen += mLatency[ b ];
+          if( total > 0 && seen >= q * total )
+             return b == 0 ? 0 : ( std::uint64_t( 1 ) << b ) - 1;
+       }
+       return 0;
+    }
+
+    std::string ToText() const
+    {
+       std::string text;
+       char line[ 96 ];
+       for( std::size_t i = 0; i < mCounters.size(); ++i )
+       {
+          std::snprintf( line, sizeof( line ), "%-18s %llu\n", kMetricNames[ i ],
+                         static_cast< unsigned long long >( mCounters[ i ] ) );
+          text += line;
+       }
+       text += "erasures:";
+       for( int e = 0; e <= kMaxErasureBucket; ++e )
+          if( mErasures[ e ] != 0 )
+          {
+             std::snprintf( line, sizeof( line ), " %d%s=%llu", e, e == kMaxErasureBucket ? "+" : "",
+                            static_cast< unsigned long long >( mErasures[ e ] ) );
+             text += line;
+          }
+       std::snprintf( line, sizeof( line ), "\nlatency_ns: p50<=%llu p90<=%llu p99<=%llu\n",
+                      static_cast< unsigned long long >( LatencyQuantile( 0.5 ) ),
+                      static_cast< unsigned long long >( LatencyQuantile( 0.9 ) ),
+                      static_cast< unsigned long long >( LatencyQuantile( 0.99 ) ) );
+       text += line;
+       return text;
+    }
+
+    std::string ToJson() const
+    {
+       std::string json = "{";
+       char item[ 64 ];
+       for( std::size_t i = 0; i < mCounters.size(); ++i )
+       {
+          std::snprintf( item, sizeof( item ), "\"%s\": %llu, ", kMetricNames[ i ],
+                         static_cast< unsigned long long >( mCounters[ i ] ) );
+          json += item;
+       }
+       auto append_array = [&]( const char* name, const auto& values ) {
+          json += "\"";
+          json += name;
+          json += "\": [";
+          for( std::size_t i = 0; i < values.size(); ++i )
+          {
+             std::snprintf( item, sizeof( item ), "%s%llu", i ? ", " : "", static_cast< unsigned long long >( values[ i ] ) );
+             json += item;
+          }
+          json += "]";
+       };
+       append_array( "erasures", mErasures );
+       json += ", ";
+       append_array( "latency_log2_ns", mLatency );
+       json += "}";
+       return json;
+    }
+ };
+
+ namespace detail
+ {
+
+ /**
+  * Счетчики одного потока. Пишет только поток-владелец (без атомарных операций чтения-изменения-записи),
+  * читает снимок; атомарность отдельных слов нужна лишь для согласованного чтения.
+  */
+ struct ThreadMetrics
+ {
+    std::array< std::atomic< std::uint64_t >, static_cast< std::size_t >( Metric::Count ) > mCounters{};
+
+    std::array< std::atomic< std::uint64_t >, kMaxErasureBucket + 1 > mErasures{};
+
+    std::array< std::atomic< std::uint64_t >, kLatencyBuckets > mLatency{};
+
+    static void Add( std::atomic< std::uint64_t >& counter, std::uint64_t value )
+    {
+       counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+    }
+
+    void AddTo( MetricsSnapshot& snapshot ) const
+    {
+       for( std::size_t i = 0; i < mCounters.size(); ++i )
+          snapshot.mCounters[ i ] += mCounters[ i ].load( std::memory_order_relaxed );
+       for( std::size_t i = 0; i < mErasures.size(); ++i )
+          snapshot.mErasures[ i ] += mErasures[ i ].load( std::memory_order_relaxed );
+       for( std::size_t i = 0; i < mLatency.size(); ++i )
+          snapshot.mLatency[ i ] += mLatency[ i ].load( std::memory_order_relaxed );
+    }
+
+    void Clear()
+    {
+       for( auto& counter : mCounters )
+          counter.store( 0, std::memory_order_relaxed );
+       for( auto& counter : mErasures )
+          counter.store( 0, std::memory_order_relaxed );
+       for( auto& counter : mLatency )
+          counter.store( 0, std::memory_order_relaxed );
+    }
+ };
+
+ /**
+  * Реестр счетчиков потоков: счетчики завершившихся потоков прибавляются к mRetired.
+  */
+ struct MetricsRegistry
+ {
+    std::mutex mMutex;
+
+    std::vector< ThreadMetrics* > mThreads;
+
+    MetricsSnapshot mRetired;
+
+    static MetricsRegistry& Instance()
+    {
+       static MetricsRegistry registry;
+       return registry;
+    }
+ };
+
+ /**
+  * Владелец счетчиков потока: регистрирует их при создании и переносит в mRetired при завершении потока.
+  */
+ struct ThreadMetricsOwner
+ {
+    ThreadMetricsOwner()
+    {
+       auto& registry = MetricsRegistry::Instance();
+       std::lock_guard lock( registry.mMutex );
+       registry.mThreads.push_back( &mMetrics );
+    }
+
+    ~ThreadMetricsOwner()
+    {
+       auto& registry = MetricsRegistry::Instance();
+       std::lock_guard lock( registry.mMutex );
+       mMetrics.AddTo( registry.mRetired );
+       std::erase( registry.mThreads, &mMetrics );
+    }
+
+    ThreadMetrics mMetrics;
+ };
+
+ inline ThreadMetrics& LocalMetrics()
+ {
+    thread_local ThreadMetricsOwner owner;
+    return owner.mMetrics;
+ }
+
+ } // namespace detail
+
+ /**
+  * Прибавить value к счетчику текущего потока.
+  */
+ inline void AddMetric( Metric metric, std::uint64_t value = 1 )
+ {
+    if constexpr( kMetricsEnabled )
+       detail::ThreadMetrics::Add( detail::LocalMetrics().mCounters[ static_cast< std::size_t >( metric ) ], value );
+ }
+
+ /**
+  * Снимок метрик: сумма по всем потокам, включая завершившиеся.
+  */
+ inline MetricsSnapshot SnapshotMetrics()
+ {
+    MetricsSnapshot snapshot;
+    if constexpr( kMetricsEnabled )
+    {
+       auto& registry = detail::MetricsRegistry::Instance();
+       std::lock_guard lock( registry.mMutex );
+       snapshot = registry.mRetired;
+       for( const auto* metrics : registry.mThreads )
+          metrics->AddTo( snapshot );
+    }
+    return snapshot;
+ }
+
+ /**
+  * Обнулить метрики. Вызывать, когда декодирование в других потоках не выполняется.
+  */
+ inline void ResetMetrics()
+ {
+    if constexpr( kMetricsEnabled )
+    {
+       auto& registry = detail::MetricsRegistry::Instance();
+       std::lock_guard lock( registry.mMutex );
+       registry.mRetired = {};
+       for( auto* metrics : registry.mThreads )
+          metrics->Clear();
+    }
+ }
+
+ /**
+  * Учет одного вызова декодера: время от создания до Finish, кратность стирания и причина отказа.
+  * При выключенных метриках объект пуст и Finish только возвращает результат.
+  */
+ class DecodeMetrics
+ {
+ public:
+    DecodeMetrics()
+    {
+       if constexpr( kMetricsEnabled )
+          mStart = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Записать итог вызова и вернуть is_ok.
+     */
+    bool Finish( int erased, int R, bool is_ok ) const
+    {
+       if constexpr( kMetricsEnabled )
+       {
+          Record( erased );
+          if( !is_ok )
+             AddMetric( erased > R ? Metric::TooManyErasures : Metric::Unrecoverable );
+       }
+       return is_ok;
+    }
+
+    /**
+     * Записать итог вызова, прерванного обнаруженной неисправимой ошибкой (DecodeErrors), и вернуть false.
+     */
+    bool FinishDetected( int erased ) const
+    {
+       if constexpr( kMetricsEnabled )
+       {
+          Record( erased );
+          AddMetric( Metric::DetectedErrors );
+       }
+       return false;
+    }
+
+ private:
+    /**
+     * Учесть вызов: счетчик вызовов, кратность стирания и задержку.
+     */
+    void Record( int erased ) const
+    {
+       const auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - mStart ).count();
+       auto& metrics = detail::LocalMetrics();
+       using detail::ThreadMetrics;
+       ThreadMetrics::Add( metrics.mCounters[ static_cast< std::size_t >( Metric::DecodeCalls ) ], 1 );
+       ThreadMetrics::Add( metrics.mErasures[ std::min( erased, kMaxErasureBucket ) ], 1 );
+       const int bucket = std::min< int >( std::bit_width( static_cast< std::uint64_t >( ns ) ), kLatencyBuckets - 1 );
+       ThreadMetrics::Add( metrics.mLatency[ bucket ], 1 );
+    }
+
+    std::chrono::steady_clock::time_point mStart;
+ };
+
+ } // namespace hamming
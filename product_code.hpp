@@ -0,0 +1,249 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm> // std::min, std::fill
+ #include <bit>       // std::countr_zero, std::popcount
+ #include <cassert>   // assert
+ #include <cstddef>   // std::size_t, std::byte
+ #include <cstdint>   // std::uint64_t, std::uint8_t
+ #include <span>      // std::span
+ #include <utility>   // std::cmp_equal, std::cmp_greater
+ #include <vector>    // std::vector
+
+ #include "hamming.hpp"
+ #include "thread_pool.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * Произведение кодов для пакетных стираний: Kc x Kr информационных символов в сетке Nc x Nr, каждая строка
+  * сетки - кодовое слово кода строк (RowR проверочных), каждый столбец - кодовое слово кода столбцов (ColumnR).
+  * Декодирование чередует проходы по строкам и по столбцам: символ, восстановленный в строке, уменьшает
+  * количество стертых в его столбце, и наоборот, пока проходы дают восстановленные символы.
+  * Отказ целой строки или столбца сетки (корзины, последовательных секторов многих полос) восстанавливается
+  * кодом другого направления. Кодирование и декодирование строк и столбцов - EncodeSymbols и DecodeSymbols
+  * исходных кодов, строки (столбцы) прохода обрабатываются в пуле потоков.
+  * Сетка задается Nc * Nr указателями на символы по строкам: символ (r, c) - grid[ r * Nr + c ], r и c - позиции
+  * в кодовых словах кода столбцов и кода строк (с учетом режимов кодирования).
+  */
+ template< typename T, int RowR, int ColumnR, int M >
+ class ProductCode
+ {
+ public:
+    using RowCode = HammingExtended< T, RowR, M >;
+
+    using ColumnCode = HammingExtended< T, ColumnR, M >;
+
+    /**
+     * @param rows, columns - коды строк и столбцов; должны существовать дольше объекта.
+     */
+    ProductCode( const RowCode& rows, const ColumnCode& columns )
+       : mRowCode( rows ), mColumnCode( columns )
+    {
+    }
+
+    /**
+     * Количество строк сетки (длина кода столбцов).
+     */
+    int Rows() const { return mColumnCode.N; }
+
+    /**
+     * Количество столбцов сетки (длина кода строк).
+     */
+    int Columns() const { return mRowCode.N; }
+
+    /**
+     * Находится ли в ячейке (r, c) информационный символ.
+     */
+    bool IsInformation( int r, int c ) const
+    {
+       return mColumnCode.SystematicIndex( r ) < mColumnCode.K && mRowCode.SystematicIndex( c ) < mRowCode.K;
+    }
+
+    /**
+     * Закодировать сетку: информационные строки кодом строк, затем все столбцы кодом столбцов
+     * (проверочные строки по линейности тоже оказываются кодовыми словами кода строк).
+     * @param grid - Rows() * Columns() указателей на буферы символов по строкам.
+     * @param bytes - размер одного символа, байт.
+     */
+    void Encode( std::span< std::byte* const > grid, std::size_t bytes, ThreadPool& pool )
+    {
+       assert( std::cmp_equal( grid.size(), Rows() * Columns() ) );
+       PrepareLanes( pool );
+       ForEachLine( pool, Rows(), [this, grid, bytes]( Lane&, int r ) {
+          if( mColumnCode.SystematicIndex( r ) < mColumnCode.K )
+             mRowCode.EncodeSymbols( grid.subspan( r * Columns(), Columns() ), bytes );
+       } );
+       ForEachLine( pool, Columns(), [this, grid, bytes]( Lane& lane, int c ) {
+          for( int r = 0; r < Rows(); ++r )
+             lane.mSymbols[ r ] = grid[ r * Columns() + c ];
+          mColumnCode.EncodeSymbols( std::span( lane.mSymbols ).first( Rows() ), bytes );
+       } );
+    }
+
+    /**
+     * Восстановить стертые символы сетки по месту чередованием проходов по строкам и столбцам.
+     * Строка (столбец) декодируется, если стертых в ней не больше R ее кода и хотя бы один из них восстановим.
+     * @param erasures - битовая карта стираний сетки: бит r * Columns() + c установлен, если символ (r, c) стерт.
+     * @param remaining - количество символов, оставшихся стертыми.
+     * Невосстановленные символы не изменяются. Возвращает false, если стертым остался информационный символ.
+     */
+    bool Decode( std::span< std::byte* const > grid, std::span< const std::uint64_t > erasures, std::size_t bytes,
+                 int& remaining, ThreadPool& pool )
+    {
+       assert( std::cmp_equal( grid.size(), Rows() * Columns() ) );
+       assert( std::cmp_greater_equal( erasures.size() * 64, Rows() * Columns() ) );
+       PrepareLanes( pool );
+       mIsErased.resize( Rows() * Columns() );
+       remaining = 0;
+       for( int cell = 0; cell < Rows() * Columns(); ++cell )
+       {
+          mIsErased[ cell ] = ( erasures[ cell / 64 ] >> ( cell % 64 ) ) & 1;
+          remaining += mIsErased[ cell ];
+       }
+       for( bool is_progress = remaining > 0; is_progress; )
+       {
+          is_progress = false;
+          for( bool is_row_pass : { true, false } )
+          {
+             const int recovered = DecodePass( grid, bytes, is_row_pass, pool );
+             remaining -= recovered;
+             is_progress |= recovered > 0 && remaining > 0;
+          }
+       }
+       for( int cell = 0; cell < Rows() * Columns(); ++cell )
+          if( mIsErased[ cell ] && IsInformation( cell / Columns(), cell % Columns() ) )
+             return false;
+       return true;
+    }
+
+ private:
+    /**
+     * Буферы одной задачи прохода: рабочие области кодов, указатели и стирания текущей строки (столбца).
+     */
+    struct Lane
+    {
+       Lane( const RowCode& rows, const ColumnCode& columns )
+          : mRowWorkspace( rows.MakeWorkspace() ), mColumnWorkspace( columns.MakeWorkspace() ),
+            mSymbols( std::max( rows.N, columns.N ) ), mErasures( ( std::max( rows.N, columns.N ) + 63 ) / 64 )
+       {
+          mIds.reserve( std::max( RowR, ColumnR ) + 1 );
+       }
+
+       DecodeWorkspace mRowWorkspace;
+
+       DecodeWorkspace mColumnWorkspace;
+
+       std::vector< std::byte* > mSymbols;
+
+       std::vector< std::uint64_t > mErasures;
+
+       /**
+        * Стертые символы строки (столбца), систематический порядок.
+        */
+       std::vector< int > mIds;
+
+       /**
+        * Символы, восстановленные задачей за проход.
+        */
+       int mRecovered = 0;
+    };
+
+    /**
+     * Буферы задач: по одному на поток пула и вызывающий поток (он тоже выполняет задачи).
+     */
+    void PrepareLanes( ThreadPool& pool )
+    {
+       while( mLanes.size() < pool.Size() + 1 )
+          mLanes.emplace_back( mRowCode, mColumnCode );
+    }
+
+    /**
+     * Выполнить function( lane, line ) для line = 0..lines-1: задача t обрабатывает строки t, t + tasks, ...
+     */
+    template< typename Function >
+    void ForEachLine( ThreadPool& pool, int lines, Function&& function )
+    {
+       const std::size_t tasks = std::min< std::size_t >( lines, mLanes.size() );
+       pool.ParallelFor( tasks, [this, lines, tasks, &function]( std::size_t t ) {
+          for( int line = t; line < lines; line += tasks )
+             function( mLanes[ t ], line );
+       } );
+    }
+
+    /**
+     * Проход по всем строкам (is_row_pass) либо столбцам. Возвращает количество восстановленных символов.
+     */
+    int DecodePass( std::span< std::byte* const > grid, std::size_t bytes, bool is_row_pass, ThreadPool& pool )
+    {
+       for( auto& lane : mLanes )
+          lane.mRecovered = 0;
+       if( is_row_pass )
+          ForEachLine( pool, Rows(), [this, grid, bytes]( Lane& lane, int r ) {
+             DecodeLine( mRowCode, lane.mRowWorkspace, lane, grid, bytes, r * Columns(), 1 );
+          } );
+       else
+          ForEachLine( pool, Columns(), [this, grid, bytes]( Lane& lane, int c ) {
+             DecodeLine( mColumnCode, lane.mColumnWorkspace, lane, grid, bytes, c, Columns() );
+          } );
+       int recovered = 0;
+       for( const auto& lane : mLanes )
+          recovered += lane.mRecovered;
+       return recovered;
+    }
+
+    /**
+     * Декодировать строку (столбец) сетки: символ p кодового слова - ячейка first + p * stride.
+     * Ячейки восстановленных символов снимаются с карты стираний.
+     */
+    template< typename Code >
+    void DecodeLine( const Code& code, DecodeWorkspace& workspace, Lane& lane, std::span< std::byte* const > grid,
+                     std::size_t bytes, int first, int stride )
+    {
+       lane.mIds.clear();
+       for( int j = 0; j < code.N; ++j )
+          if( mIsErased[ first + code.Position( j ) * stride ] )
+          {
+             lane.mIds.push_back( j );
+             if( std::cmp_greater( lane.mIds.size(), code.N - code.K ) )
+                return;
+          }
+       if( lane.mIds.empty() )
+          return;
+       const std::uint64_t recoverable = code.RecoverableMask( lane.mIds );
+       if( recoverable == 0 )
+          return;
+       const auto symbols = std::span( lane.mSymbols ).first( code.N );
+       const auto erasures = std::span( lane.mErasures ).first( ( code.N + 63 ) / 64 );
+       std::fill( erasures.begin(), erasures.end(), 0 );
+       for( int p = 0; p < code.N; ++p )
+          symbols[ p ] = grid[ first + p * stride ];
+       for( int j : lane.mIds )
+       {
+          const int p = code.Position( j );
+          erasures[ p / 64 ] |= std::uint64_t( 1 ) << ( p % 64 );
+       }
+       int erased;
+       code.DecodeSymbols( symbols, erasures, bytes, erased, workspace );
+       for( std::uint64_t mask = recoverable; mask != 0; mask &= mask - 1 )
+          mIsErased[ first + code.Position( lane.mIds[ std::countr_zero( mask ) ] ) * stride ] = 0;
+       lane.mRecovered += std::popcount( recoverable );
+    }
+
+    const RowCode& mRowCode;
+
+    const ColumnCode& mColumnCode;
+
+    std::vector< Lane > mLanes;
+
+    /**
+     * Карта стираний сетки по ячейкам (байт на ячейку: строки и столбцы прохода пишут без гонок).
+     */
+    std::vector< std::uint8_t > mIsErased;
+ };
+
+ } // namespace hamming
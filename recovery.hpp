@@ -0,0 +1,939 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm> // std::copy, std::lower_bound, std::none_of
+ #include <bit>      // std::countr_zero, std::popcount
+ #include <cassert>  // assert
+ #include <cstddef>  // std::size_t
+ #include <cstdint>  // std::uint64_t
+ #include <list>     // std::list
+ #include <map>      // std::map
+ #include <memory>   // std::shared_ptr
+ #include <span>     // std::span
+ #include <vector>   // std::vector
+
+ #include "bit_matrix.hpp"
+ #include "metrics.hpp"
+ #include "sparse_matrix.hpp"
+ #include "xor_schedule.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * План восстановления стертых символов для заданного набора стираний.
+  * Каждый стертый символ выражается суммой (XOR) нестертых символов, поэтому
+  * восстановление по плану не требует исключения Гаусса.
+  */
+ struct RecoveryPlan
+ {
+    /**
+     * Индексы стертых символов (в систематическом порядке), по возрастанию.
+     */
+    std::vector< int > mErased;
+
+    /**
+     * Матрица восстановления, dim = (e x N): строка k отмечает нестертые символы,
+     * сумма которых равна стертому символу mErased[ k ].
+     */
+    BitMatrix mRecovery;
+
+    /**
+     * Признак однозначной восстановимости каждого стертого символа.
+     */
+    std::vector< bool > mIsRecoverable;
+
+    /**
+     * Расписание XOR: индексы слагаемых строки k лежат в mSources[ mOffsets[ k ] .. mOffsets[ k + 1 ] ).
+     */
+    std::vector< int > mSources;
+
+    std::vector< int > mOffsets;
+
+    /**
+     * Порядок восстановления для последовательного плана (см. MakePeelingPlan): слагаемые строки mSources
+     * могут быть стертыми символами, восстановленными раньше в этом порядке. Пуст - строки независимы
+     * и слагаемые только нестертые.
+     */
+    std::vector< int > mOrder;
+
+    /**
+     * Расписание XOR с общими подвыражениями (необязательное, см. OptimizeRecoveryPlan).
+     * Выход i восстанавливает стертый символ mErased[ mScheduled[ i ] ].
+     */
+    XorSchedule mSchedule;
+
+    std::vector< int > mScheduled;
+
+    /**
+     * Количество XOR на одно кодовое слово при восстановлении по плану.
+     */
+    int XorCount() const
+    {
+       if( !mSchedule.Empty() )
+          return mSchedule.XorCount();
+       int count = 0;
+       for( std::size_t k = 0; k + 1 < mOffsets.size(); ++k )
+          if( mOffsets[ k + 1 ] > mOffsets[ k ] )
+             count += mOffsets[ k + 1 ] - mOffsets[ k ] - 1;
+       return count;
+    }
+
+    /**
+     * Все ли стертые символы с индексом меньше limit восстановимы.
+     */
+    bool IsRecoverable( int limit ) const
+    {
+       for( int k = 0; k < static_cast< int >( mErased.size() ); ++k )
+          if( mErased[ k ] < limit && !mIsRecoverable[ k ] )
+             return false;
+       return true;
+    }
+ };
+
+ /**
+  * Исключение Гаусса-Жордана для подматрицы стертых столбцов Hsys с учетом комбинаций строк:
+  * augmented = [ S | E ] (R x (e + R)) приводится к ступенчатому виду, pivot_row[ k ] - ведущая строка
+  * стертого столбца k либо -1.
+  */
+ inline void EliminateErased( const BitMatrix& Hsys, std::span< const int > erased_ids, BitMatrix& augmented,
+                              std::vector< int >& pivot_row )
+ {
+    const int R = Hsys.Rows();
+    const int erased = erased_ids.size();
+    augmented.Reset( R, erased + R );
+    for( int j = 0; j < R; ++j )
+    {
+       for( int i = 0; auto idx : erased_ids )
+          augmented.Set( j, i++, Hsys.Get( j, idx ) );
+       augmented.Set( j, erased + j, true );
+    }
+    pivot_row.assign( erased, -1 );
+    int rank = 0;
+    int row_ops = 0;
+    for( int k = 0; k < erased && rank < R; ++k )
+    {
+       const int where_unit = augmented.FindInColumn( k, rank );
+       if( where_unit == -1 )
+          continue;
+       augmented.SwapRows( where_unit, rank );
+       for( int i = 0; i < R; ++i )
+          if( i != rank && augmented.Get( i, k ) )
+          {
+             augmented.XorRow( i, rank );
+             ++row_ops;
+          }
+       pivot_row[ k ] = rank++;
+    }
+    AddMetric( Metric::GaussPivots, rank );
+    AddMetric( Metric::GaussRowOps, row_ops );
+ }
+
+ /**
+  * Строка восстановления стертого символа k после EliminateErased: сумма строк Hsys, отмеченных в ведущей
+  * строке, без самого символа. Возвращает false (recovery не изменяется), если символ невосстановим:
+  * столбец не ведущий или ведущая строка содержит другие стертые столбцы.
+  * @param recovery - строка длины Hsys.Words() слов, обнуленная.
+  */
+ inline bool ComposeRecoveryRow( const BitMatrix& Hsys, std::span< const int > erased_ids, const BitMatrix& augmented,
+                                 std::span< const int > pivot_row, int k, BitMatrix::Word* recovery )
+ {
+    const int R = Hsys.Rows();
+    const int erased = erased_ids.size();
+    const int row = pivot_row[ k ];
+    if( row == -1 || augmented.FindInRow( row, k + 1, erased ) != -1 )
+       return false;
+    for( int j = augmented.FindInRow( row, erased, erased + R ); j != -1; j = augmented.FindInRow( row, j + 1, erased + R ) )
+    {
+       const auto* h = Hsys.Row( j - erased );
+       for( int w = 0; w < Hsys.Words(); ++w )
+          recovery[ w ] ^= h[ w ];
+    }
+    // Сам стертый символ входит в комбинацию с единицей: переносим его в левую часть.
+    const int idx = erased_ids[ k ];
+    recovery[ idx / BitMatrix::kWordBits ] &= ~( BitMatrix::Word( 1 ) << ( idx % BitMatrix::kWordBits ) );
+    return true;
+ }
+
+ /**
+  * Строит план восстановления по систематической проверочной матрице.
+  * Подматрица стертых столбцов приводится методом Гаусса-Жордана к ступенчатому виду с одновременным
+  * учетом комбинаций строк Hsys. Стертый символ восстановим, если его столбец ведущий и ведущая
+  * строка не содержит других стертых столбцов.
+  * Сложность O(r * e * (e + r) / 64 + e * r * N / 64).
+  * @param plan - результат; его память переиспользуется.
+  * @param augmented, pivot_row - рабочие буферы; их память переиспользуется.
+  */
+ inline void MakeRecoveryPlan( const BitMatrix& Hsys, std::span< const int > erased_ids, RecoveryPlan& plan,
+                               BitMatrix& augmented, std::vector< int >& pivot_row )
+ {
+    const int N = Hsys.Cols();
+    const int erased = erased_ids.size();
+    plan.mErased.assign( erased_ids.begin(), erased_ids.end() );
+    plan.mRecovery.Reset( erased, N );
+    plan.mIsRecoverable.assign( erased, false );
+    EliminateErased( Hsys, erased_ids, augmented, pivot_row );
+    for( int k = 0; k < erased; ++k )
+       plan.mIsRecoverable[ k ] = ComposeRecoveryRow( Hsys, erased_ids, augmented, pivot_row, k, plan.mRecovery.Row( k ) );
+    plan.mSources.clear();
+    plan.mOffsets.assign( 1, 0 );
+    plan.mOrder.clear();
+    for( int k = 0; k < erased; ++k )
+    {
+       for( int i = plan.mRecovery.FindInRow( k, 0, N ); i != -1; i = plan.mRecovery.FindInRow( k, i + 1, N ) )
+          plan.mSources.push_back( i );
+       plan.mOffsets.push_back( plan.mSources.size() );
+    }
+ }
+
+ /**
+  * Слагаемые строки k плана (индексы нестертых символов, по возрастанию); false - символ невосстановим.
+  */
+ inline bool RecoverySources( const RecoveryPlan& plan, int k, std::vector< int >& sources )
+ {
+    sources.clear();
+    if( !plan.mIsRecoverable[ k ] )
+       return false;
+    const int N = plan.mRecovery.Cols();
+    for( int j = plan.mRecovery.FindInRow( k, 0, N ); j != -1; j = plan.mRecovery.FindInRow( k, j + 1, N ) )
+       sources.push_back( j );
+    return true;
+ }
+
+ /**
+  * Целевое восстановление одного стертого символа erased_ids[ k ]: исключение то же, что в MakeRecoveryPlan,
+  * но строки Hsys складываются только для ведущей строки символа k, O(r * e * (e + r) / 64 + r * N / 64).
+  * Возвращает false, если символ невосстановим.
+  * @param sources - результат: индексы нестертых символов, сумма которых равна символу, по возрастанию.
+  * @param row, augmented, pivot_row - рабочие буферы; их память переиспользуется.
+  */
+ inline bool MakeSymbolRecovery( const BitMatrix& Hsys, std::span< const int > erased_ids, int k,
+                                 std::vector< int >& sources, BitMatrix& row, BitMatrix& augmented,
+                                 std::vector< int >& pivot_row )
+ {
+    const int N = Hsys.Cols();
+    sources.clear();
+    EliminateErased( Hsys, erased_ids, augmented, pivot_row );
+    row.Reset( 1, N );
+    if( !ComposeRecoveryRow( Hsys, erased_ids, augmented, pivot_row, k, row.Row( 0 ) ) )
+       return false;
+    for( int j = row.FindInRow( 0, 0, N ); j != -1; j = row.FindInRow( 0, j + 1, N ) )
+       sources.push_back( j );
+    return true;
+ }
+
+ /**
+  * Рабочие буферы декодера с выщипыванием; их память переиспользуется.
+  */
+ struct PeelingBuffers
+ {
+    /**
+     * Номер стертого символа по индексу символа, либо -1 (между вызовами все элементы равны -1).
+     */
+    std::vector< int > mSlot;
+
+    /**
+     * Количество еще не восстановленных стертых символов в проверке.
+     */
+    std::vector< int > mDegree;
+
+    /**
+     * XOR индексов еще не восстановленных стертых символов проверки: для проверки степени 1 - сам символ.
+     */
+    std::vector< int > mXorSum;
+
+    /**
+     * Очередь проверок степени 1.
+     */
+    std::vector< int > mQueue;
+
+    /**
+     * Проверка, по которой восстановлен стертый символ k, либо -1.
+     */
+    std::vector< int > mCheck;
+
+    /**
+     * Стертые символы, оставшиеся после выщипывания (множество остановки), и план для них.
+     */
+    std::vector< int > mResidual;
+
+    RecoveryPlan mResidualPlan;
+ };
+
+ /**
+  * Строит последовательный план восстановления выщипыванием (peeling) по разреженной проверочной матрице.
+  * Пока есть проверка ровно с одним невосстановленным стертым символом, символ выражается суммой остальных
+  * символов проверки; сложность O(количество ребер стертых столбцов). Оставшиеся символы (множество остановки)
+  * восстанавливаются исключением Гаусса по Hsys, где уже восстановленные символы считаются известными.
+  * Восстановимость символов та же, что у MakeRecoveryPlan.
+  * @param H - разреженная проверочная матрица; столбцы - в систематическом порядке (как у Hsys).
+  * @param buffers, augmented, pivot_row - рабочие буферы; их память переиспользуется.
+  */
+ inline void MakePeelingPlan( const SparseMatrix& H, const BitMatrix& Hsys, std::span< const int > erased_ids,
+                              RecoveryPlan& plan, PeelingBuffers& buffers, BitMatrix& augmented,
+                              std::vector< int >& pivot_row )
+ {
+    const int R = H.Rows();
+    const int N = H.Cols();
+    const int erased = erased_ids.size();
+    auto& slot = buffers.mSlot;
+    auto& degree = buffers.mDegree;
+    auto& xor_sum = buffers.mXorSum;
+    auto& queue = buffers.mQueue;
+    auto& check = buffers.mCheck;
+    slot.resize( N, -1 );
+    degree.assign( R, 0 );
+    xor_sum.assign( R, 0 );
+    queue.clear();
+    check.assign( erased, -1 );
+    plan.mErased.assign( erased_ids.begin(), erased_ids.end() );
+    plan.mRecovery.Reset( erased, N );
+    plan.mIsRecoverable.assign( erased, false );
+    plan.mOrder.clear();
+    for( int k = 0; k < erased; ++k )
+    {
+       const int j = erased_ids[ k ];
+       slot[ j ] = k;
+       for( int r : H.Column( j ) )
+       {
+          ++degree[ r ];
+          xor_sum[ r ] ^= j;
+       }
+    }
+    for( int r = 0; r < R; ++r )
+       if( degree[ r ] == 1 )
+          queue.push_back( r );
+    // Каждая проверка попадает в очередь не более одного раза: степень только убывает.
+    for( std::size_t q = 0; q < queue.size(); ++q )
+    {
+       const int r = queue[ q ];
+       if( degree[ r ] != 1 )
+          continue;
+       const int j = xor_sum[ r ];
+       const int k = slot[ j ];
+       check[ k ] = r;
+       plan.mIsRecoverable[ k ] = true;
+       plan.mOrder.push_back( k );
+       for( int c : H.Column( j ) )
+       {
+          xor_sum[ c ] ^= j;
+          if( --degree[ c ] == 1 )
+             queue.push_back( c );
+       }
+    }
+    const int peeled = plan.mOrder.size();
+    AddMetric( Metric::PeeledSymbols, peeled );
+    auto& residual = buffers.mResidual;
+    auto& residual_plan = buffers.mResidualPlan;
+    residual.clear();
+    for( int k = 0; k < erased; ++k )
+       if( !plan.mIsRecoverable[ k ] )
+          residual.push_back( erased_ids[ k ] );
+    if( !residual.empty() )
+    {
+       MakeRecoveryPlan( Hsys, residual, residual_plan, augmented, pivot_row );
+       for( int i = 0; i < static_cast< int >( residual.size() ); ++i )
+       {
+          if( !residual_plan.mIsRecoverable[ i ] )
+             continue;
+          const int k = slot[ residual[ i ] ];
+          plan.mIsRecoverable[ k ] = true;
+          plan.mOrder.push_back( k );
+       }
+    }
+    // Слагаемые шага и строка восстановления по нестертым символам (подстановка ранее восстановленных).
+    auto add_source = [&]( int k, int source ) {
+       if( slot[ source ] == -1 )
+       {
+          plan.mRecovery.Flip( k, source );
+          return;
+       }
+       const auto* from = plan.mRecovery.Row( slot[ source ] );
+       auto* to = plan.mRecovery.Row( k );
+       for( int w = 0; w < plan.mRecovery.Words(); ++w )
+          to[ w ] ^= from[ w ];
+    };
+    for( int step = 0; step < static_cast< int >( plan.mOrder.size() ); ++step )
+    {
+       const int k = plan.mOrder[ step ];
+       if( step < peeled )
+       {
+          for( int source : H.Row( check[ k ] ) )
+             if( source != erased_ids[ k ] )
+                add_source( k, source );
+          continue;
+       }
+       const int i = std::lower_bound( residual.begin(), residual.end(), erased_ids[ k ] ) - residual.begin();
+       for( int source = residual_plan.mRecovery.FindInRow( i, 0, N ); source != -1;
+            source = residual_plan.mRecovery.FindInRow( i, source + 1, N ) )
+          add_source( k, source );
+    }
+    plan.mSources.clear();
+    plan.mOffsets.assign( 1, 0 );
+    for( int k = 0; k < erased; ++k )
+    {
+       if( check[ k ] != -1 )
+       {
+          for( int source : H.Row( check[ k ] ) )
+             if( source != erased_ids[ k ] )
+                plan.mSources.push_back( source );
+       }
+       else if( plan.mIsRecoverable[ k ] )
+       {
+          const int i = std::lower_bound( residual.begin(), residual.end(), erased_ids[ k ] ) - residual.begin();
+          for( int source = residual_plan.mRecovery.FindInRow( i, 0, N ); source != -1;
+               source = residual_plan.mRecovery.FindInRow( i, source + 1, N ) )
+             plan.mSources.push_back( source );
+       }
+       plan.mOffsets.push_back( plan.mSources.size() );
+    }
+    for( int j : erased_ids )
+       slot[ j ] = -1;
+ }
+
+ /**
+  * Построить для плана расписание XOR с общими подвыражениями (по восстановимым символам).
+  * Выполняется для планов, которые переиспользуются (кэш), так как построение расписания дороже исключения.
+  * Последовательные планы выщипывания уже разрежены и не изменяются.
+  */
+ inline void OptimizeRecoveryPlan( RecoveryPlan& plan )
+ {
+    if( !plan.mOrder.empty() )
+       return;
+    plan.mScheduled.clear();
+    for( int k = 0; k < static_cast< int >( plan.mErased.size() ); ++k )
+       if( plan.mIsRecoverable[ k ] )
+          plan.mScheduled.push_back( k );
+    BitMatrix rows( plan.mScheduled.size(), plan.mRecovery.Cols() );
+    for( int i = 0; auto k : plan.mScheduled )
+    {
+       std::copy( plan.mRecovery.Row( k ), plan.mRecovery.Row( k ) + rows.Words(), rows.Row( i ) );
+       ++i;
+    }
+    plan.mSchedule = MakeXorSchedule( rows );
+ }
+
+ inline RecoveryPlan MakeRecoveryPlan( const BitMatrix& Hsys, std::span< const int > erased_ids )
+ {
+    RecoveryPlan plan;
+    BitMatrix augmented;
+    std::vector< int > pivot_row;
+    MakeRecoveryPlan( Hsys, erased_ids, plan, augmented, pivot_row );
+    return plan;
+ }
+
+ inline RecoveryPlan MakePeelingPlan( const SparseMatrix& H, const BitMatrix& Hsys, std::span< const int > erased_ids )
+ {
+    RecoveryPlan plan;
+    PeelingBuffers buffers;
+    BitMatrix augmented;
+    std::vector< int > pivot_row;
+    MakePeelingPlan( H, Hsys, erased_ids, plan, buffers, augmented, pivot_row );
+    return plan;
+ }
+
+ /**
+  * План ремонта без данных: для каждого восстановимого стертого символа - набор нестертых символов,
+  * сумма которых его восстанавливает, с наименьшим найденным количеством чтений.
+  */
+ struct RepairPlan
+ {
+    /**
+     * Индексы стертых символов (в систематическом порядке), по возрастанию.
+     */
+    std::vector< int > mErased;
+
+    std::vector< bool > mIsRecoverable;
+
+    /**
+     * Индексы нестертых символов для стертого символа k: mReads[ mOffsets[ k ] .. mOffsets[ k + 1 ] ), по возрастанию.
+     * Для невосстановимого символа набор пуст.
+     */
+    std::vector< int > mReads;
+
+    std::vector< int > mOffsets;
+
+    std::span< const int > Reads( int k ) const
+    {
+       return std::span< const int >( mReads ).subspan( mOffsets[ k ], mOffsets[ k + 1 ] - mOffsets[ k ] );
+    }
+
+    /**
+     * Все ли стертые символы с индексом меньше limit восстановимы.
+     */
+    bool IsRecoverable( int limit ) const
+    {
+       for( int k = 0; k < static_cast< int >( mErased.size() ); ++k )
+          if( mErased[ k ] < limit && !mIsRecoverable[ k ] )
+             return false;
+       return true;
+    }
+ };
+
+ /**
+  * Предел перебора для точного минимума в MakeRepairPlan: 2^d * (слов в строке) операций на стертый символ.
+  */
+ inline constexpr std::size_t kRepairSearchWords = std::size_t( 1 ) << 22;
+
+ /**
+  * Строит план ремонта по систематической проверочной матрице, не используя данных.
+  * Комбинация для стертого символа определена с точностью до проверок, не содержащих стертых символов
+  * (ядро подматрицы стертых столбцов, размерность d = R - ранг). Если 2^d невелико, перебором в коде Грея
+  * находится комбинация с наименьшим количеством чтений; иначе вес уменьшается жадно прибавлением проверок
+  * базиса ядра и строк разреженной матрицы H без стертых символов.
+  * @param H - необязательная разреженная проверочная матрица (столбцы в систематическом порядке).
+  */
+ inline void MakeRepairPlan( const BitMatrix& Hsys, std::span< const int > erased_ids, RepairPlan& repair,
+                             const SparseMatrix* H = nullptr )
+ {
+    const int R = Hsys.Rows();
+    const int N = Hsys.Cols();
+    const int erased = erased_ids.size();
+    RecoveryPlan plan;
+    BitMatrix augmented;
+    std::vector< int > pivot_row;
+    MakeRecoveryPlan( Hsys, erased_ids, plan, augmented, pivot_row );
+    int rank = 0;
+    for( int row : pivot_row )
+       rank += row != -1;
+    // Строки rank..R-1 после исключения не содержат стертых столбцов: базис ядра, выраженный через строки Hsys.
+    const int dims = R - rank;
+    std::vector< bool > is_erased( N, false );
+    for( int j : erased_ids )
+       is_erased[ j ] = true;
+    int sparse_checks = 0;
+    if( H != nullptr )
+       for( int i = 0; i < H->Rows(); ++i )
+          sparse_checks += std::none_of( H->Row( i ).begin(), H->Row( i ).end(), [&]( int j ) { return is_erased[ j ]; } );
+    BitMatrix checks( dims + sparse_checks, N );
+    for( int r = rank; r < R; ++r )
+    {
+       auto* check = checks.Row( r - rank );
+       for( int j = augmented.FindInRow( r, erased, erased + R ); j != -1; j = augmented.FindInRow( r, j + 1, erased + R ) )
+       {
+          const auto* h = Hsys.Row( j - erased );
+          for( int w = 0; w < Hsys.Words(); ++w )
+             check[ w ] ^= h[ w ];
+       }
+    }
+    if( H != nullptr )
+       for( int i = 0, c = dims; i < H->Rows(); ++i )
+          if( std::none_of( H->Row( i ).begin(), H->Row( i ).end(), [&]( int j ) { return is_erased[ j ]; } ) )
+          {
+             for( int j : H->Row( i ) )
+                checks.Set( c, j, true );
+             ++c;
+          }
+    const int words = Hsys.Words();
+    const bool exact = dims < 63 && ( std::size_t( 1 ) << dims ) <= kRepairSearchWords / std::max( words, 1 );
+    BitMatrix work( 2, N ); // 0 - текущая комбинация, 1 - лучшая.
+    repair.mErased.assign( erased_ids.begin(), erased_ids.end() );
+    repair.mIsRecoverable = plan.mIsRecoverable;
+    repair.mReads.clear();
+    repair.mOffsets.assign( 1, 0 );
+    for( int k = 0; k < erased; ++k )
+    {
+       if( plan.mIsRecoverable[ k ] )
+       {
+          auto* current = work.Row( 0 );
+          auto* best = work.Row( 1 );
+          std::copy( plan.mRecovery.Row( k ), plan.mRecovery.Row( k ) + words, current );
+          std::copy( current, current + words, best );
+          int best_weight = work.Weight( 0 );
+          if( exact )
+          {
+             for( std::size_t g = 1; g < ( std::size_t( 1 ) << dims ); ++g )
+             {
+                const auto* check = checks.Row( std::countr_zero( g ) );
+                for( int w = 0; w < words; ++w )
+                   current[ w ] ^= check[ w ];
+                if( const int weight = work.Weight( 0 ); weight < best_weight )
+                {
+                   best_weight = weight;
+                   std::copy( current, current + words, best );
+                }
+             }
+          }
+          else
+          {
+             for( bool improved = true; improved; )
+             {
+                improved = false;
+                for( int c = 0; c < checks.Rows(); ++c )
+                {
+                   const auto* check = checks.Row( c );
+                   int weight = 0;
+                   for( int w = 0; w < words; ++w )
+                      weight += std::popcount( best[ w ] ^ check[ w ] );
+                   if( weight < best_weight )
+                   {
+                      best_weight = weight;
+                      for( int w = 0; w < words; ++w )
+                         best[ w ] ^= check[ w ];
+                      improved = true;
+                   }
+                }
+             }
+          }
+          for( int j = work.FindInRow( 1, 0, N ); j != -1; j = work.FindInRow( 1, j + 1, N ) )
+             repair.mReads.push_back( j );
+       }
+       repair.mOffsets.push_back( repair.mReads.size() );
+    }
+ }
+
+ inline RepairPlan MakeRepairPlan( const BitMatrix& Hsys, std::span< const int > erased_ids,
+                                   const SparseMatrix* H = nullptr )
+ {
+    RepairPlan repair;
+    MakeRepairPlan( Hsys, erased_ids, repair, H );
+    return repair;
+ }
+
+ /**
+  * Наибольшее R, для которого столбцы проверочной матрицы упаковываются в одно 64-битное слово.
+  */
+ inline constexpr int kMaxMaskR = 64;
+
+ /**
+  * Столбцы Hsys, упакованные в 64-битные слова: бит i слова j - элемент Hsys(i, j). Требует R <= kMaxMaskR.
+  */
+ inline std::vector< std::uint64_t > MakeColumnMasks( const BitMatrix& Hsys )
+ {
+    assert( Hsys.Rows() <= kMaxMaskR );
+    std::vector< std::uint64_t > columns( Hsys.Cols(), 0 );
+    for( int i = 0; i < Hsys.Rows(); ++i )
+       for( int j = Hsys.FindInRow( i, 0, Hsys.Cols() ); j != -1; j = Hsys.FindInRow( i, j + 1, Hsys.Cols() ) )
+          columns[ j ] |= std::uint64_t( 1 ) << i;
+    return columns;
+ }
+
+ /**
+  * Проверка восстановимости набора стираний без данных, по тому же правилу, что у MakeRecoveryPlan:
+  * стертый символ восстановим, если его столбец не выражается через столбцы остальных стертых.
+  * Столбцы приводятся к базису по младшему биту; каждый зависимый столбец дает соотношение (вектор
+  * ядра подматрицы), и невосстановимы ровно символы, входящие хотя бы в одно соотношение.
+  * Сложность O(R * e) операций над словами, память не выделяется.
+  * @param columns - столбцы Hsys (MakeColumnMasks).
+  * Возвращает маску восстановимых стертых символов: бит k - символ erased_ids[ k ], e <= 64.
+  */
+ inline std::uint64_t RecoverableMask( std::span< const std::uint64_t > columns, int R,
+                                       std::span< const int > erased_ids )
+ {
+    assert( R <= kMaxMaskR && erased_ids.size() <= 64 );
+    const int erased = erased_ids.size();
+    std::uint64_t basis[ kMaxMaskR ];
+    std::uint64_t combination[ kMaxMaskR ];
+    std::uint64_t has_basis = 0;
+    std::uint64_t dependent = 0;
+    for( int k = 0; k < erased; ++k )
+    {
+       std::uint64_t column = columns[ erased_ids[ k ] ];
+       std::uint64_t used = std::uint64_t( 1 ) << k;
+       while( column != 0 )
+       {
+          const int bit = std::countr_zero( column );
+          if( ( ( has_basis >> bit ) & 1 ) == 0 )
+          {
+             basis[ bit ] = column;
+             combination[ bit ] = used;
+             has_basis |= std::uint64_t( 1 ) << bit;
+             break;
+          }
+          column ^= basis[ bit ];
+          used ^= combination[ bit ];
+       }
+       if( column == 0 )
+          dependent |= used;
+    }
+    const std::uint64_t all = erased == 64 ? ~std::uint64_t( 0 ) : ( std::uint64_t( 1 ) << erased ) - 1;
+    return all & ~dependent;
+ }
+
+ /**
+  * Наибольшее R, при котором таблица синдром -> столбец хранится целиком (2^R элементов).
+  */
+ inline constexpr int kMaxSyndromeTableR = 16;
+
+ /**
+  * Значения таблицы синдромов: столбца с таким синдромом нет либо таких столбцов несколько.
+  */
+ inline constexpr int kNoColumn = -1;
+
+ inline constexpr int kAmbiguousColumn = -2;
+
+ /**
+  * Таблица синдром -> столбец для исправления одной ошибки: элемент s - индекс столбца Hsys, равного s,
+  * kNoColumn или kAmbiguousColumn (совпадающие столбцы, код с расстоянием меньше 3). При R > kMaxSyndromeTableR пуста.
+  * @param columns - столбцы Hsys (MakeColumnMasks).
+  */
+ inline std::vector< int > MakeSyndromeTable( std::span< const std::uint64_t > columns, int R )
+ {
+    if( R > kMaxSyndromeTableR )
+       return {};
+    std::vector< int > table( std::size_t( 1 ) << R, kNoColumn );
+    for( int j = 0; j < static_cast< int >( columns.size() ); ++j )
+    {
+       int& column = table[ columns[ j ] ];
+       column = column == kNoColumn ? j : kAmbiguousColumn;
+    }
+    return table;
+ }
+
+ /**
+  * Базис столбцов стертых символов по младшему биту (как в RecoverableMask). Приведение синдрома
+  * к базису исключает вклад стертых символов: остаются только проверки, в которые стертые не входят.
+  */
+ struct ErasureBasis
+ {
+    /**
+     * @param columns - столбцы Hsys (MakeColumnMasks).
+     */
+    ErasureBasis( std::span< const std::uint64_t > columns, std::span< const int > erased_ids )
+    {
+       for( int id : erased_ids )
+       {
+          const std::uint64_t column = Reduce( columns[ id ] );
+          if( column == 0 )
+             continue;
+          const int bit = std::countr_zero( column );
+          mBasis[ bit ] = column;
+          mPivots |= std::uint64_t( 1 ) << bit;
+       }
+    }
+
+    /**
+     * Представитель смежного класса mask по линейной оболочке базиса: биты ведущих элементов равны нулю.
+     */
+    std::uint64_t Reduce( std::uint64_t mask ) const
+    {
+       for( std::uint64_t pivots = mask & mPivots; pivots != 0; pivots = mask & mPivots )
+          mask ^= mBasis[ std::countr_zero( pivots ) ];
+       return mask;
+    }
+
+    std::uint64_t mBasis[ kMaxMaskR ];
+
+    /**
+     * Биты ведущих элементов: бит i установлен, если mBasis[ i ] задан.
+     */
+    std::uint64_t mPivots = 0;
+ };
+
+ /**
+  * Столбец, приведенный синдром которого равен pattern (одна ошибка), без учета стертых символов.
+  * @param table - таблица MakeSyndromeTable; используется, если стертых нет.
+  * Возвращает индекс столбца, kNoColumn или kAmbiguousColumn.
+  */
+ inline int LocateErrorColumn( std::span< const std::uint64_t > columns, std::span< const int > table,
+                               const ErasureBasis& basis, std::uint64_t pattern )
+ {
+    assert( pattern != 0 );
+    if( basis.mPivots == 0 && !table.empty() )
+       return table[ pattern ];
+    int found = kNoColumn;
+    for( int j = 0; j < static_cast< int >( columns.size() ); ++j )
+    {
+       if( basis.Reduce( columns[ j ] ) != pattern )
+          continue;
+       if( found != kNoColumn )
+          return kAmbiguousColumn;
+       found = j;
+    }
+    return found;
+ }
+
+ /**
+  * Рабочая область декодера, принадлежащая вызывающей стороне (например, по одной на поток).
+  * Память выделяется один раз по R и N; декодирование с рабочей областью не выделяет память и не меняет
+  * объект кода, поэтому один код можно использовать из многих потоков.
+  * Запоминает план для последнего набора стираний: повтор набора не требует исключения Гаусса.
+  */
+ struct DecodeWorkspace
+ {
+    DecodeWorkspace( int R, int N )
+    {
+       mErased.reserve( R + 1 );
+       mPlan.mErased.reserve( R );
+       mPlan.mRecovery = BitMatrix( R, N );
+       mPlan.mIsRecoverable.reserve( R );
+       mPlan.mSources.reserve( static_cast< std::size_t >( R ) * N );
+       mPlan.mOffsets.reserve( R + 1 );
+       mPlan.mOrder.reserve( R );
+       mAugmented = BitMatrix( R, 2 * R );
+       mPivotRow.reserve( R );
+       mSources.reserve( N );
+       mRow = BitMatrix( 1, N );
+       mPeeling.mSlot.assign( N, -1 );
+       mPeeling.mDegree.reserve( R );
+       mPeeling.mXorSum.reserve( R );
+       mPeeling.mQueue.reserve( R );
+       mPeeling.mCheck.reserve( R );
+       mPeeling.mResidual.reserve( R );
+       auto& residual = mPeeling.mResidualPlan;
+       residual.mErased.reserve( R );
+       residual.mRecovery = BitMatrix( R, N );
+       residual.mIsRecoverable.reserve( R );
+       residual.mSources.reserve( static_cast< std::size_t >( R ) * N );
+       residual.mOffsets.reserve( R + 1 );
+    }
+
+    /**
+     * Подготовить план для набора стираний mErased.
+     * @param H - разреженная проверочная матрица (столбцы в систематическом порядке); если задана,
+     * план строится выщипыванием (MakePeelingPlan).
+     */
+    const RecoveryPlan& Plan( const BitMatrix& Hsys, const SparseMatrix* H = nullptr )
+    {
+       if( !mIsPlanValid || mPlan.mErased != mErased )
+       {
+          if( H )
+             MakePeelingPlan( *H, Hsys, mErased, mPlan, mPeeling, mAugmented, mPivotRow );
+          else
+             MakeRecoveryPlan( Hsys, mErased, mPlan, mAugmented, mPivotRow );
+          mIsPlanValid = true;
+          AddMetric( Metric::PlansBuilt );
+       }
+       else
+       {
+          AddMetric( Metric::PlanCacheHits );
+       }
+       return mPlan;
+    }
+
+    /**
+     * Слагаемые mSources для одного стертого символа mErased[ k ]; false - символ невосстановим.
+     * Если план для текущего набора уже построен, берется его строка; для разреженной H строится весь план
+     * выщипыванием (он дешев), иначе исключение выполняется только для символа k (MakeSymbolRecovery).
+     */
+    bool SymbolSources( const BitMatrix& Hsys, int k, const SparseMatrix* H = nullptr )
+    {
+       if( H || ( mIsPlanValid && mPlan.mErased == mErased ) )
+          return RecoverySources( Plan( Hsys, H ), k, mSources );
+       return MakeSymbolRecovery( Hsys, mErased, k, mSources, mRow, mAugmented, mPivotRow );
+    }
+
+    /**
+     * Индексы стертых символов текущего вызова (не более R + 1).
+     */
+    std::vector< int > mErased;
+
+    /**
+     * Слагаемые целевого восстановления (SymbolSources) и рабочая строка для него.
+     */
+    std::vector< int > mSources;
+
+    BitMatrix mRow;
+
+    RecoveryPlan mPlan;
+
+    bool mIsPlanValid = false;
+
+    BitMatrix mAugmented;
+
+    std::vector< int > mPivotRow;
+
+    PeelingBuffers mPeeling;
+ };
+
+ /**
+  * Ограниченный кэш планов восстановления с вытеснением давно не использованных (LRU).
+  * Ключ - набор индексов стертых символов.
+  */
+ class RecoveryCache
+ {
+ public:
+    explicit RecoveryCache( std::size_t capacity = 64 ) : mCapacity( capacity ) {}
+
+    /**
+     * Найти план; при успехе план становится самым свежим.
+     */
+    std::shared_ptr< const RecoveryPlan > Find( const std::vector< int >& erased_ids )
+    {
+       auto it = mIndex.find( erased_ids );
+       if( it == mIndex.end() )
+       {
+          ++mMisses;
+          return nullptr;
+       }
+       ++mHits;
+       mItems.splice( mItems.begin(), mItems, it->second );
+       return *it->second;
+    }
+
+    void Insert( std::shared_ptr< const RecoveryPlan > plan )
+    {
+       if( mCapacity == 0 )
+          return;
+       if( auto it = mIndex.find( plan->mErased ); it != mIndex.end() )
+       {
+          *it->second = std::move( plan );
+          mItems.splice( mItems.begin(), mItems, it->second );
+          return;
+       }
+       while( mItems.size() >= mCapacity )
+       {
+          mIndex.erase( mItems.back()->mErased );
+          mItems.pop_back();
+       }
+       mItems.push_front( std::move( plan ) );
+       mIndex.emplace( mItems.front()->mErased, mItems.begin() );
+    }
+
+    void SetCapacity( std::size_t capacity )
+    {
+       mCapacity = capacity;
+       while( mItems.size() > mCapacity )
+       {
+          mIndex.erase( mItems.back()->mErased );
+          mItems.pop_back();
+       }
+    }
+
+    void Clear()
+    {
+       mItems.clear();
+       mIndex.clear();
+    }
+
+    std::size_t Capacity() const { return mCapacity; }
+
+    std::size_t Size() const { return mItems.size(); }
+
+    /**
+     * Количество попаданий в кэш.
+     */
+    std::size_t Hits() const { return mHits; }
+
+    /**
+     * Количество промахов кэша.
+     */
+    std::size_t Misses() const { return mMisses; }
+
+    void ResetCounters()
+    {
+       mHits = 0;
+       mMisses = 0;
+    }
+
+ private:
+    using Items = std::list< std::shared_ptr< const RecoveryPlan > >;
+
+    std::size_t mCapacity;
+
+    std::size_t mHits = 0;
+
+    std::size_t mMisses = 0;
+
+    /**
+     * Планы от самого свежего к самому старому.
+     */
+    Items mItems;
+
+    std::map< std::vector< int >, Items::iterator > mIndex;
+ };
+
+ } // namespace hamming
@@ -0,0 +1,97 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm> // std::sort
+ #include <cassert> // assert
+ #include <cstddef> // std::size_t
+ #include <span>    // std::span
+ #include <utility> // std::cmp_equal
+ #include <vector>  // std::vector
+
+ #include "bit_matrix.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * Разреженная двоичная матрица: индексы ненулевых элементов по строкам (CSR) и по столбцам (CSC).
+  * Для проверочных матриц LDPC-кодов, у которых вес строки много меньше длины кода.
+  */
+ struct SparseMatrix
+ {
+    SparseMatrix() = default;
+
+    /**
+     * Построить по плотной матрице.
+     * @param columns - необязательная перестановка: столбец j результата - столбец columns[ j ] матрицы H.
+     */
+    explicit SparseMatrix( const BitMatrix& H, std::span< const int > columns = {} )
+       : mRows( H.Rows() ), mCols( H.Cols() )
+    {
+       assert( columns.empty() || std::cmp_equal( columns.size(), mCols ) );
+       std::vector< int > to_result( mCols );
+       for( int j = 0; j < mCols; ++j )
+          to_result[ columns.empty() ? j : columns[ j ] ] = j;
+       mRowOffsets.assign( 1, 0 );
+       mColOffsets.assign( mCols + 1, 0 );
+       for( int i = 0; i < mRows; ++i )
+       {
+          for( int j = H.FindInRow( i, 0, mCols ); j != -1; j = H.FindInRow( i, j + 1, mCols ) )
+          {
+             mRowIndices.push_back( to_result[ j ] );
+             ++mColOffsets[ to_result[ j ] + 1 ];
+          }
+          std::sort( mRowIndices.begin() + mRowOffsets.back(), mRowIndices.end() );
+          mRowOffsets.push_back( mRowIndices.size() );
+       }
+       for( int j = 0; j < mCols; ++j )
+          mColOffsets[ j + 1 ] += mColOffsets[ j ];
+       mColIndices.resize( mRowIndices.size() );
+       std::vector< int > fill( mColOffsets.begin(), mColOffsets.end() - 1 );
+       for( int i = 0; i < mRows; ++i )
+          for( int j : Row( i ) )
+             mColIndices[ fill[ j ]++ ] = i;
+    }
+
+    int Rows() const { return mRows; }
+
+    int Cols() const { return mCols; }
+
+    /**
+     * Количество ненулевых элементов (ребер графа Таннера).
+     */
+    std::size_t Edges() const { return mRowIndices.size(); }
+
+    /**
+     * Индексы столбцов строки i, по возрастанию.
+     */
+    std::span< const int > Row( int i ) const
+    {
+       return std::span< const int >( mRowIndices ).subspan( mRowOffsets[ i ], mRowOffsets[ i + 1 ] - mRowOffsets[ i ] );
+    }
+
+    /**
+     * Индексы строк столбца j, по возрастанию.
+     */
+    std::span< const int > Column( int j ) const
+    {
+       return std::span< const int >( mColIndices ).subspan( mColOffsets[ j ], mColOffsets[ j + 1 ] - mColOffsets[ j ] );
+    }
+
+    int mRows = 0;
+
+    int mCols = 0;
+
+    std::vector< int > mRowOffsets;
+
+    std::vector< int > mRowIndices;
+
+    std::vector< int > mColOffsets;
+
+    std::vector< int > mColIndices;
+ };
+
+ } // namespace hamming
@@ -0,0 +1,215 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm>     // std::fill
+ #include <cassert>       // assert
+ #include <cstddef>       // std::size_t, std::byte
+ #include <cstdint>       // std::uint64_t
+ #include <cstring>       // std::memcpy, std::memset
+ #include <span>          // std::span
+ #include <unordered_map> // std::unordered_map
+ #include <utility>       // std::cmp_equal
+ #include <vector>        // std::vector
+
+ #include "hamming.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * Потоковый кодер: информационные символы полосы поступают по одному и в любом порядке, каждый сразу
+  * прибавляется (XOR) к накопителям тех проверочных символов, в строках которых его столбец mHsys равен
+  * единице. Когда получены все K символов, проверочные символы полосы готовы; полный вектор не хранится.
+  * Одновременно открыто не более capacity полос: память накопителей выделяется один раз.
+  * Объект не потокобезопасен: один кодер на поток приема либо внешняя блокировка.
+  */
+ template< typename T, int R, int M >
+ class StreamEncoder
+ {
+ public:
+    /**
+     * @param code - код; должен существовать дольше кодера. Режим кодирования учитывается в момент вызова Add.
+     * @param bytes - размер одного символа, байт.
+     * @param capacity - наибольшее количество одновременно открытых полос.
+     */
+    StreamEncoder( const HammingExtended< T, R, M >& code, std::size_t bytes, std::size_t capacity )
+       : mCode( code ), mBytes( bytes ), mSlots( capacity ), mParity( capacity * R * bytes )
+    {
+       mOffsets.assign( 1, 0 );
+       for( int k = 0; k < code.K; ++k )
+       {
+          for( int i = code.mHsys.FindInColumn( k ); i != -1; i = code.mHsys.FindInColumn( k, i + 1 ) )
+             mRows.push_back( i );
+          mOffsets.push_back( mRows.size() );
+       }
+       for( std::size_t s = 0; s < capacity; ++s )
+       {
+          mSlots[ s ].mReceived.assign( ( code.K + 63 ) / 64, 0 );
+          mSlots[ s ].mTouched.assign( R, false );
+          mFree.push_back( capacity - 1 - s );
+       }
+       mIndex.reserve( capacity );
+    }
+
+    /**
+     * Принять информационный символ полосы stripe в позиции position кодового слова (с учетом режима).
+     * Полоса открывается при первом символе. Возвращает false, если в позиции проверочный символ,
+     * символ уже получен или все накопители заняты.
+     */
+    bool Add( std::uint64_t stripe, int position, const std::byte* symbol )
+    {
+       assert( position >= 0 && position < mCode.N );
+       const int k = mCode.SystematicIndex( position );
+       if( k >= mCode.K )
+          return false;
+       auto it = mIndex.find( stripe );
+       if( it == mIndex.end() )
+       {
+          if( mFree.empty() )
+             return false;
+          it = mIndex.emplace( stripe, mFree.back() ).first;
+          mFree.pop_back();
+       }
+       Slot& slot = mSlots[ it->second ];
+       auto& word = slot.mReceived[ k / 64 ];
+       const std::uint64_t bit = std::uint64_t( 1 ) << ( k % 64 );
+       if( word & bit )
+          return false;
+       word |= bit;
+       ++slot.mCount;
+       std::byte* parity = Accumulators( it->second );
+       for( int r = mOffsets[ k ]; r < mOffsets[ k + 1 ]; ++r )
+       {
+          const int i = mRows[ r ];
+          if( slot.mTouched[ i ] )
+          {
+             XorInto( parity + i * mBytes, symbol, mBytes );
+          }
+          else
+          {
+             std::memcpy( parity + i * mBytes, symbol, mBytes );
+             slot.mTouched[ i ] = true;
+          }
+       }
+       if( slot.mCount == mCode.K )
+       {
+          // Проверочные символы, не зависящие ни от одного информационного, равны нулю.
+          for( int i = 0; i < R; ++i )
+             if( !slot.mTouched[ i ] )
+                std::memset( parity + i * mBytes, 0, mBytes );
+       }
+       return true;
+    }
+
+    /**
+     * Получены ли все K информационных символов полосы.
+     */
+    bool IsComplete( std::uint64_t stripe ) const
+    {
+       const auto it = mIndex.find( stripe );
+       return it != mIndex.end() && mSlots[ it->second ].mCount == mCode.K;
+    }
+
+    /**
+     * Проверочный символ i (позиция Position( K + i ) кодового слова) завершенной полосы, либо nullptr.
+     * Указатель действителен до Release( stripe ).
+     */
+    const std::byte* Parity( std::uint64_t stripe, int i ) const
+    {
+       assert( i >= 0 && i < R );
+       const auto it = mIndex.find( stripe );
+       if( it == mIndex.end() || mSlots[ it->second ].mCount != mCode.K )
+          return nullptr;
+       return mParity.data() + ( it->second * R + i ) * mBytes;
+    }
+
+    /**
+     * Скопировать проверочные символы завершенной полосы в буферы кодового слова и освободить накопитель.
+     * @param codeword - N указателей в порядке кодового слова; используются только указатели проверочных символов.
+     * Возвращает false, если полоса не завершена.
+     */
+    bool TakeParity( std::uint64_t stripe, std::span< std::byte* const > codeword )
+    {
+       assert( std::cmp_equal( codeword.size(), mCode.N ) );
+       if( !IsComplete( stripe ) )
+          return false;
+       for( int i = 0; i < R; ++i )
+          std::memcpy( codeword[ mCode.Position( mCode.K + i ) ], Parity( stripe, i ), mBytes );
+       Release( stripe );
+       return true;
+    }
+
+    /**
+     * Освободить накопитель полосы (завершенной или прерванной).
+     */
+    void Release( std::uint64_t stripe )
+    {
+       const auto it = mIndex.find( stripe );
+       if( it == mIndex.end() )
+          return;
+       Slot& slot = mSlots[ it->second ];
+       std::fill( slot.mReceived.begin(), slot.mReceived.end(), 0 );
+       std::fill( slot.mTouched.begin(), slot.mTouched.end(), false );
+       slot.mCount = 0;
+       mFree.push_back( it->second );
+       mIndex.erase( it );
+    }
+
+    /**
+     * Количество открытых полос.
+     */
+    std::size_t InFlight() const { return mIndex.size(); }
+
+    std::size_t Capacity() const { return mSlots.size(); }
+
+ private:
+    /**
+     * Состояние открытой полосы.
+     */
+    struct Slot
+    {
+       /**
+        * Битовая карта полученных информационных символов (систематический индекс).
+        */
+       std::vector< std::uint64_t > mReceived;
+
+       /**
+        * Записан ли в накопитель i хотя бы один символ (первый символ копируется, не складывается).
+        */
+       std::vector< bool > mTouched;
+
+       int mCount = 0;
+    };
+
+    std::byte* Accumulators( std::size_t slot )
+    {
+       return mParity.data() + slot * R * mBytes;
+    }
+
+    const HammingExtended< T, R, M >& mCode;
+
+    std::size_t mBytes;
+
+    /**
+     * Строки mHsys, зависящие от информационного символа k: mRows[ mOffsets[ k ] .. mOffsets[ k + 1 ] ).
+     */
+    std::vector< int > mRows;
+
+    std::vector< int > mOffsets;
+
+    std::vector< Slot > mSlots;
+
+    /**
+     * Накопители всех полос подряд: R символов на полосу.
+     */
+    std::vector< std::byte > mParity;
+
+    std::vector< std::size_t > mFree;
+
+    std::unordered_map< std::uint64_t, std::size_t > mIndex;
+ };
+
+ } // namespace hamming
@@ -0,0 +1,536 @@
+/**
+ * Разбиение файла на полосы: K файлов данных и R проверочных файлов (shard_000 .. shard_{N-1}) и
+ * восстановление отсутствующих файлов. Файл обрабатывается окнами из нескольких полос через выровненные
+ * буферы (pread/pwrite), поэтому объем памяти ограничен и не зависит от размера файла.
+ * Символ j полосы s лежит в файле shard_j по смещению s * symbol; символы 0..K-1 - данные
+ * (систематический режим), K..N-1 - проверочные. Последняя полоса дополняется нулями.
+ * Запуск:
+ *    stripe encode <input> <dir> [--r R] [--symbol bytes] [--memory MiB] [--threads n]
+ *    stripe rebuild <dir> [--memory MiB] [--threads n]
+ *    stripe decode <dir> <output> [--memory MiB] [--threads n]
+ */
+
+#include <algorithm> // std::min, std::max
+#include <chrono>    // std::chrono
+#include <cstdio>    // std::printf, std::snprintf
+#include <cstdlib>   // std::aligned_alloc, std::free
+#include <cstring>   // std::strcmp, std::memcpy, std::memset
+#include <fstream>   // std::ifstream, std::ofstream
+#include <iostream>  // std::cerr
+#include <memory>    // std::unique_ptr
+#include <string>    // std::string
+#include <thread>    // std::thread
+#include <utility>   // std::integer_sequence, std::cmp_not_equal
+#include <vector>    // std::vector
+
+#include <fcntl.h>    // open
+#include <sys/stat.h> // stat
+#include <unistd.h>   // pread, pwrite, ftruncate, close
+
+#include "hamming.hpp"
+
+namespace
+{
+
+using namespace hamming;
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+   std::string mCommand;
+
+   std::string mInput;
+
+   std::string mDir;
+
+   std::string mOutput;
+
+   int mR = 4;
+
+   std::size_t mSymbolBytes = 64 * 1024;
+
+   std::size_t mMemoryBytes = std::size_t( 256 ) << 20;
+
+   unsigned mThreads = std::thread::hardware_concurrency();
+};
+
+/**
+ * Описание набора файлов полос (manifest.txt в каталоге).
+ */
+struct Manifest
+{
+   int mR = 0;
+
+   std::size_t mSymbolBytes = 0;
+
+   std::uint64_t mFileBytes = 0;
+};
+
+constexpr const char* kManifestMagic = "exhamming-stripe";
+
+constexpr int kManifestVersion = 1;
+
+/**
+ * Выравнивание буферов: страница, чтобы ядро копировало данные целыми страницами.
+ */
+constexpr std::size_t kBufferAlignment = 4096;
+
+std::string ManifestPath( const std::string& dir )
+{
+   return dir + "/manifest.txt";
+}
+
+std::string ShardPath( const std::string& dir, int j )
+{
+   char name[ 32 ];
+   std::snprintf( name, sizeof( name ), "/shard_%03d", j );
+   return dir + name;
+}
+
+bool SaveManifest( const std::string& dir, const Manifest& manifest )
+{
+   std::ofstream out( ManifestPath( dir ) );
+   out << kManifestMagic << ' ' << kManifestVersion << '\n'
+       << "R " << manifest.mR << '\n'
+       << "symbol_bytes " << manifest.mSymbolBytes << '\n'
+       << "file_bytes " << manifest.mFileBytes << '\n';
+   return bool( out );
+}
+
+bool LoadManifest( const std::string& dir, Manifest& manifest )
+{
+   std::ifstream in( ManifestPath( dir ) );
+   std::string magic, key;
+   int version = 0;
+   if( !( in >> magic >> version ) || magic != kManifestMagic || version != kManifestVersion )
+      return false;
+   in >> key >> manifest.mR >> key >> manifest.mSymbolBytes >> key >> manifest.mFileBytes;
+   return bool( in ) && manifest.mSymbolBytes > 0;
+}
+
+/**
+ * Дескриптор файла, закрываемый в деструкторе.
+ */
+class File
+{
+public:
+   File() = default;
+
+   File( const std::string& path, int flags ) : mFd( ::open( path.c_str(), flags, 0644 ) ) {}
+
+   File( File&& other ) noexcept : mFd( other.mFd ) { other.mFd = -1; }
+
+   File& operator=( File&& other ) noexcept
+   {
+      std::swap( mFd, other.mFd );
+      return *this;
+   }
+
+   ~File()
+   {
+      if( mFd >= 0 )
+         ::close( mFd );
+   }
+
+   bool IsOpen() const { return mFd >= 0; }
+
+   /**
+    * Прочитать до bytes байт; возвращает количество прочитанных (меньше bytes только в конце файла), -1 при ошибке.
+    */
+   long long Read( std::byte* data, std::size_t bytes, std::uint64_t offset ) const
+   {
+      std::size_t done = 0;
+      while( done < bytes )
+      {
+         const ssize_t n = ::pread( mFd, data + done, bytes - done, offset + done );
+         if( n < 0 )
+            return -1;
+         if( n == 0 )
+            break;
+         done += n;
+      }
+      return done;
+   }
+
+   bool Write( const std::byte* data, std::size_t bytes, std::uint64_t offset ) const
+   {
+      std::size_t done = 0;
+      while( done < bytes )
+      {
+         const ssize_t n = ::pwrite( mFd, data + done, bytes - done, offset + done );
+         if( n <= 0 )
+            return false;
+         done += n;
+      }
+      return true;
+   }
+
+   bool Truncate( std::uint64_t bytes ) const { return ::ftruncate( mFd, bytes ) == 0; }
+
+private:
+   int mFd = -1;
+};
+
+/**
+ * Размер файла либо -1, если файла нет.
+ */
+long long FileSize( const std::string& path )
+{
+   struct stat st;
+   return ::stat( path.c_str(), &st ) == 0 ? static_cast< long long >( st.st_size ) : -1;
+}
+
+struct AlignedFree
+{
+   void operator()( std::byte* p ) const { std::free( p ); }
+};
+
+using Buffer = std::unique_ptr< std::byte, AlignedFree >;
+
+Buffer MakeBuffer( std::size_t bytes )
+{
+   const std::size_t size = ( std::max< std::size_t >( bytes, 1 ) + kBufferAlignment - 1 ) / kBufferAlignment * kBufferAlignment;
+   return Buffer( static_cast< std::byte* >( std::aligned_alloc( kBufferAlignment, size ) ) );
+}
+
+/**
+ * Окно из нескольких полос: по буферу на каждый из N файлов и указатели на символы каждой полосы.
+ */
+struct Window
+{
+   Window( int N, std::size_t symbol_bytes, std::size_t stripes ) : mN( N ), mSymbolBytes( symbol_bytes ), mStripes( stripes )
+   {
+      for( int j = 0; j < N; ++j )
+         mShards.push_back( MakeBuffer( stripes * symbol_bytes ) );
+      mPointers.resize( stripes * N );
+      for( std::size_t s = 0; s < stripes; ++s )
+         for( int j = 0; j < N; ++j )
+            mPointers[ s * N + j ] = mShards[ j ].get() + s * symbol_bytes;
+   }
+
+   std::byte* Shard( int j ) { return mShards[ j ].get(); }
+
+   /**
+    * Полосы [0, count) для EncodeStripes и DecodeStripes.
+    */
+   std::vector< std::span< std::byte* const > > Stripes( std::size_t count ) const
+   {
+      std::vector< std::span< std::byte* const > > stripes;
+      for( std::size_t s = 0; s < count; ++s )
+         stripes.emplace_back( mPointers.data() + s * mN, mN );
+      return stripes;
+   }
+
+   int mN;
+
+   std::size_t mSymbolBytes;
+
+   std::size_t mStripes;
+
+   std::vector< Buffer > mShards;
+
+   std::vector< std::byte* > mPointers;
+};
+
+/**
+ * Количество полос в окне: N буферов по stripes * symbol байт укладываются в бюджет памяти.
+ */
+std::size_t WindowStripes( int N, std::size_t symbol_bytes, std::size_t memory_bytes )
+{
+   return std::max< std::size_t >( 1, memory_bytes / ( std::size_t( N ) * symbol_bytes ) );
+}
+
+/**
+ * Время ввода-вывода и вычислений.
+ */
+struct Timing
+{
+   Clock::time_point mStart = Clock::now();
+
+   double mCompute = 0;
+
+   template< typename F >
+   void Compute( F&& f )
+   {
+      const auto start = Clock::now();
+      f();
+      mCompute += std::chrono::duration< double >( Clock::now() - start ).count();
+   }
+
+   void Report( const char* operation, std::uint64_t bytes ) const
+   {
+      const double total = std::chrono::duration< double >( Clock::now() - mStart ).count();
+      std::printf( "%s: %llu bytes in %.3f s, %.1f MB/s (compute %.3f s, %.1f MB/s; I/O %.3f s)\n", operation,
+                   static_cast< unsigned long long >( bytes ), total, bytes / total * 1e-6, mCompute,
+                   mCompute > 0 ? bytes / mCompute * 1e-6 : 0.0, total - mCompute );
+   }
+};
+
+template< int R >
+int Encode( const Options& options, ThreadPool& pool )
+{
+   HammingExtended< std::uint64_t, R, 1 > code;
+   const int N = code.N;
+   const int K = code.K;
+   const std::size_t B = options.mSymbolBytes;
+   const long long file_bytes = FileSize( options.mInput );
+   File input( options.mInput, O_RDONLY );
+   if( file_bytes < 0 || !input.IsOpen() )
+   {
+      std::cerr << options.mInput << ": cannot open\n";
+      return 1;
+   }
+   const std::uint64_t stripes = ( file_bytes + K * B - 1 ) / ( K * B );
+   std::vector< File > shards;
+   for( int j = 0; j < N; ++j )
+   {
+      shards.emplace_back( ShardPath( options.mDir, j ), O_WRONLY | O_CREAT | O_TRUNC );
+      if( !shards.back().IsOpen() || !shards.back().Truncate( stripes * B ) )
+      {
+         std::cerr << ShardPath( options.mDir, j ) << ": cannot create\n";
+         return 1;
+      }
+   }
+   Timing timing;
+   Window window( N, B, WindowStripes( N + K, B, options.mMemoryBytes ) );
+   Buffer chunk = MakeBuffer( window.mStripes * K * B );
+   for( std::uint64_t first = 0; first < stripes; first += window.mStripes )
+   {
+      const std::size_t count = std::min< std::uint64_t >( window.mStripes, stripes - first );
+      const long long n = input.Read( chunk.get(), count * K * B, first * K * B );
+      if( n < 0 )
+      {
+         std::cerr << options.mInput << ": read error\n";
+         return 1;
+      }
+      std::memset( chunk.get() + n, 0, count * K * B - n );
+      timing.Compute( [&] {
+         for( std::size_t s = 0; s < count; ++s )
+            for( int i = 0; i < K; ++i )
+               std::memcpy( window.Shard( i ) + s * B, chunk.get() + ( s * K + i ) * B, B );
+         code.EncodeStripes( window.Stripes( count ), B, pool );
+      } );
+      for( int j = 0; j < N; ++j )
+         if( !shards[ j ].Write( window.Shard( j ), count * B, first * B ) )
+         {
+            std::cerr << ShardPath( options.mDir, j ) << ": write error\n";
+            return 1;
+         }
+   }
+   if( !SaveManifest( options.mDir, { .mR = R, .mSymbolBytes = B, .mFileBytes = std::uint64_t( file_bytes ) } ) )
+   {
+      std::cerr << ManifestPath( options.mDir ) << ": cannot write\n";
+      return 1;
+   }
+   std::printf( "R = %d, N = %d, K = %d, symbol %zu bytes, %llu stripes\n", R, N, K, B,
+                static_cast< unsigned long long >( stripes ) );
+   timing.Report( "encode", file_bytes );
+   return 0;
+}
+
+/**
+ * Восстановление: rebuild записывает отсутствующие файлы полос, decode - исходный файл в options.mOutput.
+ * План восстановления строится один раз для набора отсутствующих файлов и применяется ко всем полосам.
+ */
+template< int R >
+int Reconstruct( const Options& options, const Manifest& manifest, ThreadPool& pool )
+{
+   HammingExtended< std::uint64_t, R, 1 > code;
+   const int N = code.N;
+   const int K = code.K;
+   const std::size_t B = manifest.mSymbolBytes;
+   const bool rebuild = options.mCommand == "rebuild";
+   const std::uint64_t stripes = ( manifest.mFileBytes + K * B - 1 ) / ( K * B );
+   std::vector< std::uint64_t > erasures( ( N + 63 ) / 64 );
+   std::vector< File > shards( N );
+   std::vector< int > missing;
+   for( int j = 0; j < N; ++j )
+   {
+      const auto path = ShardPath( options.mDir, j );
+      if( FileSize( path ) == static_cast< long long >( stripes * B ) )
+         shards[ j ] = File( path, O_RDONLY );
+      if( !shards[ j ].IsOpen() )
+      {
+         missing.push_back( j );
+         erasures[ j / 64 ] |= std::uint64_t( 1 ) << ( j % 64 );
+      }
+   }
+   // Проверка без данных: безнадежный набор отсеивается до чтения файлов.
+   RepairPlan repair;
+   if( !code.GetRepairPlan( erasures, repair ) )
+   {
+      std::cerr << missing.size() << " shard(s) missing, data is not recoverable\n";
+      return 2;
+   }
+   bool reencode = false;
+   for( std::size_t k = 0; k < repair.mErased.size(); ++k )
+      reencode |= !repair.mIsRecoverable[ k ];
+   std::printf( "%zu shard(s) missing%s\n", missing.size(), reencode ? ", parity is re-encoded" : "" );
+   if( rebuild )
+   {
+      if( missing.empty() )
+         return 0;
+      for( int j : missing )
+      {
+         shards[ j ] = File( ShardPath( options.mDir, j ), O_WRONLY | O_CREAT | O_TRUNC );
+         if( !shards[ j ].IsOpen() || !shards[ j ].Truncate( stripes * B ) )
+         {
+            std::cerr << ShardPath( options.mDir, j ) << ": cannot create\n";
+            return 1;
+         }
+      }
+   }
+   File output;
+   if( !rebuild )
+   {
+      output = File( options.mOutput, O_WRONLY | O_CREAT | O_TRUNC );
+      if( !output.IsOpen() || !output.Truncate( manifest.mFileBytes ) )
+      {
+         std::cerr << options.mOutput << ": cannot create\n";
+         return 1;
+      }
+   }
+   Timing timing;
+   Window window( N, B, WindowStripes( rebuild ? N : N + K, B, options.mMemoryBytes ) );
+   Buffer chunk = rebuild ? Buffer() : MakeBuffer( window.mStripes * K * B );
+   for( std::uint64_t first = 0; first < stripes; first += window.mStripes )
+   {
+      const std::size_t count = std::min< std::uint64_t >( window.mStripes, stripes - first );
+      for( int j = 0; j < N; ++j )
+      {
+         if( ( erasures[ j / 64 ] >> ( j % 64 ) ) & 1 )
+            continue;
+         if( shards[ j ].Read( window.Shard( j ), count * B, first * B ) != static_cast< long long >( count * B ) )
+         {
+            std::cerr << ShardPath( options.mDir, j ) << ": read error\n";
+            return 1;
+         }
+      }
+      int erased = 0;
+      bool is_decoded = false;
+      timing.Compute( [&] {
+         const auto stripe_list = window.Stripes( count );
+         is_decoded = code.DecodeStripes( stripe_list, erasures, B, erased, pool );
+         if( !is_decoded )
+            return;
+         if( rebuild && reencode )
+            code.EncodeStripes( stripe_list, B, pool );
+         if( !rebuild )
+            for( std::size_t s = 0; s < count; ++s )
+               for( int i = 0; i < K; ++i )
+                  std::memcpy( chunk.get() + ( s * K + i ) * B, window.Shard( i ) + s * B, B );
+      } );
+      // Предварительная проверка и декодер должны совпадать; при расхождении данные не записываются.
+      if( !is_decoded || std::cmp_not_equal( erased, missing.size() ) )
+      {
+         std::cerr << "stripes " << first << ".." << first + count - 1 << ": decode failed\n";
+         return 2;
+      }
+      bool is_ok = true;
+      if( rebuild )
+      {
+         for( int j : missing )
+            is_ok &= shards[ j ].Write( window.Shard( j ), count * B, first * B );
+      }
+      else
+      {
+         const std::uint64_t offset = first * K * B;
+         is_ok = output.Write( chunk.get(), std::min< std::uint64_t >( count * K * B, manifest.mFileBytes - offset ), offset );
+      }
+      if( !is_ok )
+      {
+         std::cerr << "write error\n";
+         return 1;
+      }
+   }
+   timing.Report( rebuild ? "rebuild" : "decode", rebuild ? stripes * B * missing.size() : manifest.mFileBytes );
+   return 0;
+}
+
+/**
+ * Встроенные коды: R выбирается во время выполнения из диапазона kMinR..kMaxR.
+ */
+constexpr int kMinR = 3;
+
+constexpr int kMaxR = 8;
+
+template< int... Rs >
+int Dispatch( int r, const Options& options, const Manifest& manifest, ThreadPool& pool,
+              std::integer_sequence< int, Rs... > )
+{
+   int result = -1;
+   ( ... || ( r == Rs + kMinR && ( result = options.mCommand == "encode" ? Encode< Rs + kMinR >( options, pool )
+                                                                       : Reconstruct< Rs + kMinR >( options, manifest, pool ),
+                                   true ) ) );
+   if( result == -1 )
+      std::cerr << "R = " << r << " is not supported (" << kMinR << ".." << kMaxR << ")\n";
+   return result == -1 ? 1 : result;
+}
+
+void Usage( const char* name )
+{
+   std::cerr << "Usage:\n"
+             << "  " << name << " encode <input> <dir> [--r R] [--symbol bytes] [--memory MiB] [--threads n]\n"
+             << "  " << name << " rebuild <dir> [--memory MiB] [--threads n]\n"
+             << "  " << name << " decode <dir> <output> [--memory MiB] [--threads n]\n";
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+   Options options;
+   std::vector< std::string > positional;
+   for( int i = 1; i < argc; ++i )
+   {
+      if( std::strcmp( argv[ i ], "--r" ) == 0 && i + 1 < argc )
+         options.mR = std::stoi( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--symbol" ) == 0 && i + 1 < argc )
+         options.mSymbolBytes = std::stoull( argv[ ++i ] );
+      else if( std::strcmp( argv[ i ], "--memory" ) == 0 && i + 1 < argc )
+         options.mMemoryBytes = std::stoull( argv[ ++i ] ) << 20;
+      else if( std::strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc )
+         options.mThreads = std::stoul( argv[ ++i ] );
+      else
+         positional.push_back( argv[ i ] );
+   }
+   if( positional.empty() )
+   {
+      Usage( argv[ 0 ] );
+      return 1;
+   }
+   options.mCommand = positional[ 0 ];
+   Manifest manifest;
+   if( options.mCommand == "encode" && positional.size() == 3 )
+   {
+      options.mInput = positional[ 1 ];
+      options.mDir = positional[ 2 ];
+      if( options.mSymbolBytes == 0 || options.mSymbolBytes % 64 != 0 )
+      {
+         std::cerr << "--symbol must be a positive multiple of 64\n";
+         return 1;
+      }
+      ::mkdir( options.mDir.c_str(), 0755 );
+   }
+   else if( ( options.mCommand == "rebuild" && positional.size() == 2 ) ||
+            ( options.mCommand == "decode" && positional.size() == 3 ) )
+   {
+      options.mDir = positional[ 1 ];
+      if( options.mCommand == "decode" )
+         options.mOutput = positional[ 2 ];
+      if( !LoadManifest( options.mDir, manifest ) )
+      {
+         std::cerr << ManifestPath( options.mDir ) << ": cannot read\n";
+         return 1;
+      }
+      options.mR = manifest.mR;
+   }
+   else
+   {
+      Usage( argv[ 0 ] );
+      return 1;
+   }
+   ThreadPool pool( options.mThreads );
+   return Dispatch( options.mR, options, manifest, pool, std::make_integer_sequence< int, kMaxR - kMinR + 1 >{} );
+}
@@ -0,0 +1,207 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm>          // std::max, std::min
+ #include <atomic>             // std::atomic
+ #include <condition_variable> // std::condition_variable
+ #include <cstddef>            // std::size_t
+ #include <deque>              // std::deque
+ #include <functional>         // std::function
+ #include <memory>             // std::unique_ptr
+ #include <mutex>              // std::mutex
+ #include <thread>             // std::thread
+ #include <vector>             // std::vector
+
+ namespace hamming
+ {
+
+ /**
+  * Пул потоков с перехватом задач (work stealing). У каждого потока своя очередь: поток берет задачи
+  * с конца своей очереди, а при ее опустошении перехватывает задачи с начала чужих очередей.
+  * Поток, вызвавший ParallelFor, тоже выполняет задачи, пока они не закончатся.
+  */
+ class ThreadPool
+ {
+ public:
+    explicit ThreadPool( unsigned threads = std::thread::hardware_concurrency() )
+    {
+       threads = std::max( threads, 1u );
+       for( unsigned i = 0; i < threads; ++i )
+          mQueues.push_back( std::make_unique< Queue >() );
+       for( unsigned i = 0; i < threads; ++i )
+          mThreads.emplace_back( [this, i] { WorkerLoop( i ); } );
+    }
+
+    ~ThreadPool()
+    {
+       {
+          std::lock_guard lock( mSleepMutex );
+          mStop = true;
+       }
+       mWakeUp.notify_all();
+       for( auto& thread : mThreads )
+          thread.join();
+    }
+
+    ThreadPool( const ThreadPool& ) = delete;
+
+    ThreadPool& operator=( const ThreadPool& ) = delete;
+
+    unsigned Size() const { return mThreads.size(); }
+
+    /**
+     * Выполнить function(i) для i = 0..count-1 и дождаться завершения всех вызовов.
+     */
+    template< typename Function >
+    void ParallelFor( std::size_t count, Function&& function )
+    {
+       if( count == 0 )
+          return;
+       if( count == 1 )
+       {
+          function( std::size_t( 0 ) );
+          return;
+       }
+       std::atomic< std::size_t > remaining{ count };
+       const unsigned self = Self();
+       for( std::size_t i = 0; i < count; ++i )
+       {
+          const unsigned q = self != kNoWorker ? self : static_cast< unsigned >( ( mNext++ ) % mQueues.size() );
+          std::lock_guard lock( mQueues[ q ]->mMutex );
+          mQueues[ q ]->mTasks.emplace_back( [&function, &remaining, i] {
+             function( i );
+             remaining.fetch_sub( 1, std::memory_order_release );
+          } );
+       }
+       {
+          std::lock_guard lock( mSleepMutex );
+          mPending.fetch_add( count, std::memory_order_release );
+       }
+       mWakeUp.notify_all();
+       while( remaining.load( std::memory_order_acquire ) != 0 )
+       {
+          if( !RunOne( self ) )
+             std::this_thread::yield();
+       }
+    }
+
+ private:
+    using Task = std::function< void() >;
+
+    struct Queue
+    {
+       std::mutex mMutex;
+
+       std::deque< Task > mTasks;
+    };
+
+    static constexpr unsigned kNoWorker = ~0u;
+
+    /**
+     * Номер очереди текущего потока в этом пуле, либо kNoWorker.
+     */
+    unsigned Self() const
+    {
+       return tOwner == this ? tIndex : kNoWorker;
+    }
+
+    /**
+     * Выполнить одну задачу: свою (с конца) или перехваченную (с начала чужой очереди).
+     */
+    bool RunOne( unsigned self )
+    {
+       Task task;
+       const unsigned size = mQueues.size();
+       if( self != kNoWorker )
+       {
+          std::lock_guard lock( mQueues[ self ]->mMutex );
+          auto& tasks = mQueues[ self ]->mTasks;
+          if( !tasks.empty() )
+          {
+             task = std::move( tasks.back() );
+             tasks.pop_back();
+          }
+       }
+       const unsigned start = self != kNoWorker ? self + 1 : 0;
+       for( unsigned k = 0; !task && k < size; ++k )
+       {
+          const unsigned q = ( start + k ) % size;
+          if( q == self )
+             continue;
+          std::lock_guard lock( mQueues[ q ]->mMutex );
+          auto& tasks = mQueues[ q ]->mTasks;
+          if( !tasks.empty() )
+          {
+             task = std::move( tasks.front() );
+             tasks.pop_front();
+          }
+       }
+       if( !task )
+          return false;
+       mPending.fetch_sub( 1, std::memory_order_relaxed );
+       task();
+       return true;
+    }
+
+    void WorkerLoop( unsigned index )
+    {
+       tOwner = this;
+       tIndex = index;
+       for( ;; )
+       {
+          if( RunOne( index ) )
+             continue;
+          std::unique_lock lock( mSleepMutex );
+          mWakeUp.wait( lock, [this] { return mStop || mPending.load( std::memory_order_acquire ) > 0; } );
+          if( mStop && mPending.load( std::memory_order_acquire ) == 0 )
+             return;
+       }
+    }
+
+    static inline thread_local const ThreadPool* tOwner = nullptr;
+
+    static inline thread_local unsigned tIndex = kNoWorker;
+
+    std::vector< std::unique_ptr< Queue > > mQueues;
+
+    std::vector< std::thread > mThreads;
+
+    std::atomic< std::size_t > mPending{ 0 };
+
+    std::atomic< std::size_t > mNext{ 0 };
+
+    std::mutex mSleepMutex;
+
+    std::condition_variable mWakeUp;
+
+    bool mStop = false;
+ };
+
+ /**
+  * Размер порции символа для параллельной обработки: порция всех N символов кодового слова
+  * и промежуточные суммы расписания должны помещаться в кэш ядра.
+  */
+ inline constexpr std::size_t kParallelChunkBytes = 64 * 1024;
+
+ /**
+  * Разбить stripes полос по bytes байт на порции не более chunk байт и обработать их в пуле:
+  * function(stripe, offset, n) для каждой порции [offset, offset + n) каждой полосы.
+  */
+ template< typename Function >
+ inline void ParallelChunks( ThreadPool& pool, std::size_t stripes, std::size_t bytes, Function&& function,
+                             std::size_t chunk = kParallelChunkBytes )
+ {
+    if( stripes == 0 || bytes == 0 )
+       return;
+    chunk = std::max< std::size_t >( chunk, 64 );
+    const std::size_t chunks = ( bytes + chunk - 1 ) / chunk;
+    pool.ParallelFor( stripes * chunks, [&]( std::size_t task ) {
+       const std::size_t offset = ( task % chunks ) * chunk;
+       function( task / chunks, offset, std::min( chunk, bytes - offset ) );
+    } );
+ }
+
+ } // namespace hamming
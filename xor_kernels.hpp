@@ -0,0 +1,224 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <chrono>  // std::chrono
+ #include <cstddef> // std::byte, std::size_t
+ #include <cstdint> // std::uint64_t
+ #include <cstring> // std::memcpy
+ #include <vector>  // std::vector
+
+ #if ( defined( __x86_64__ ) || defined( __i386__ ) ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+ #define HAMMING_XOR_X86 1
+ #include <immintrin.h>
+ #else
+ #define HAMMING_XOR_X86 0
+ #endif
+
+ namespace hamming
+ {
+
+ /**
+  * Ядро сложения по месту: dst ^= src, n байт. Буферы не перекрываются (либо совпадают).
+  */
+ using XorKernel = void ( * )( std::byte* dst, const std::byte* src, std::size_t n );
+
+ struct XorKernelInfo
+ {
+    const char* mName;
+
+    XorKernel mKernel;
+ };
+
+ namespace detail
+ {
+
+ inline void XorIntoPortable( std::byte* dst, const std::byte* src, std::size_t n )
+ {
+    std::size_t i = 0;
+    for( ; i + sizeof( std::uint64_t ) <= n; i += sizeof( std::uint64_t ) )
+    {
+       std::uint64_t a, b;
+       std::memcpy( &a, dst + i, sizeof( a ) );
+       std::memcpy( &b, src + i, sizeof( b ) );
+       a ^= b;
+       std::memcpy( dst + i, &a, sizeof( a ) );
+    }
+    for( ; i < n; ++i )
+       dst[ i ] ^= src[ i ];
+ }
+
+ #if HAMMING_XOR_X86
+
+ __attribute__(( target( "sse2" ) ))
+ inline void XorIntoSse2( std::byte* dst, const std::byte* src, std::size_t n )
+ {
+    std::size_t i = 0;
+    for( ; i + 64 <= n; i += 64 )
+    {
+       auto* d = reinterpret_cast< __m128i* >( dst + i );
+       const auto* s = reinterpret_cast< const __m128i* >( src + i );
+       const __m128i x0 = _mm_xor_si128( _mm_loadu_si128( d + 0 ), _mm_loadu_si128( s + 0 ) );
+       const __m128i x1 = _mm_xor_si128( _mm_loadu_si128( d + 1 ), _mm_loadu_si128( s + 1 ) );
+       const __m128i x2 = _mm_xor_si128( _mm_loadu_si128( d + 2 ), _mm_loadu_si128( s + 2 ) );
+       const __m128i x3 = _mm_xor_si128( _mm_loadu_si128( d + 3 ), _mm_loadu_si128( s + 3 ) );
+       _mm_storeu_si128( d + 0, x0 );
+       _mm_storeu_si128( d + 1, x1 );
+       _mm_storeu_si128( d + 2, x2 );
+       _mm_storeu_si128( d + 3, x3 );
+    }
+    for( ; i + 16 <= n; i += 16 )
+    {
+       auto* d = reinterpret_cast< __m128i* >( dst + i );
+       _mm_storeu_si128( d, _mm_xor_si128( _mm_loadu_si128( d ),
+                                           _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i ) ) ) );
+    }
+    XorIntoPortable( dst + i, src + i, n - i );
+ }
+
+ __attribute__(( target( "avx2" ) ))
+ inline void XorIntoAvx2( std::byte* dst, const std::byte* src, std::size_t n )
+ {
+    std::size_t i = 0;
+    for( ; i + 128 <= n; i += 128 )
+    {
+       auto* d = reinterpret_cast< __m256i* >( dst + i );
+       const auto* s = reinterpret_cast< const __m256i* >( src + i );
+       const __m256i x0 = _mm256_xor_si256( _mm256_loadu_si256( d + 0 ), _mm256_loadu_si256( s + 0 ) );
+       const __m256i x1 = _mm256_xor_si256( _mm256_loadu_si256( d + 1 ), _mm256_loadu_si256( s + 1 ) );
+       const __m256i x2 = _mm256_xor_si256( _mm256_loadu_si256( d + 2 ), _mm256_loadu_si256( s + 2 ) );
+       const __m256i x3 = _mm256_xor_si256( _mm256_loadu_si256( d + 3 ), _mm256_loadu_si256( s + 3 ) );
+       _mm256_storeu_si256( d + 0, x0 );
+       _mm256_storeu_si256( d + 1, x1 );
+       _mm256_storeu_si256( d + 2, x2 );
+       _mm256_storeu_si256( d + 3, x3 );
+    }
+    for( ; i + 32 <= n; i += 32 )
+    {
+       auto* d = reinterpret_cast< __m256i* >( dst + i );
+       _mm256_storeu_si256( d, _mm256_xor_si256( _mm256_loadu_si256( d ),
+                                                 _mm256_loadu_si256( reinterpret_cast< const __m256i* >( src + i ) ) ) );
+    }
+    XorIntoPortable( dst + i, src + i, n - i );
+ }
+
+ __attribute__(( target( "avx512f" ) ))
+ inline void XorIntoAvx512( std::byte* dst, const std::byte* src, std::size_t n )
+ {
+    std::size_t i = 0;
+    for( ; i + 256 <= n; i += 256 )
+    {
+       std::byte* d = dst + i;
+       const std::byte* s = src + i;
+       const __m512i x0 = _mm512_xor_si512( _mm512_loadu_si512( d + 0 ), _mm512_loadu_si512( s + 0 ) );
+       const __m512i x1 = _mm512_xor_si512( _mm512_loadu_si512( d + 64 ), _mm512_loadu_si512( s + 64 ) );
+       const __m512i x2 = _mm512_xor_si512( _mm512_loadu_si512( d + 128 ), _mm512_loadu_si512( s + 128 ) );
+       const __m512i x3 = _mm512_xor_si512( _mm512_loadu_si512( d + 192 ), _mm512_loadu_si512( s + 192 ) );
+       _mm512_storeu_si512( d + 0, x0 );
+       _mm512_storeu_si512( d + 64, x1 );
+       _mm512_storeu_si512( d + 128, x2 );
+       _mm512_storeu_si512( d + 192, x3 );
+    }
+    for( ; i + 64 <= n; i += 64 )
+       _mm512_storeu_si512( dst + i, _mm512_xor_si512( _mm512_loadu_si512( dst + i ), _mm512_loadu_si512( src + i ) ) );
+    XorIntoPortable( dst + i, src + i, n - i );
+ }
+
+ #endif // HAMMING_XOR_X86
+
+ } // namespace detail
+
+ /**
+  * Ядра, доступные на данном процессоре, от простого к самому широкому.
+  */
+ inline const std::vector< XorKernelInfo >& AvailableXorKernels()
+ {
+    static const std::vector< XorKernelInfo > kernels = [] {
+       std::vector< XorKernelInfo > result{ { "portable", &detail::XorIntoPortable } };
+ #if HAMMING_XOR_X86
+       __builtin_cpu_init();
+       if( __builtin_cpu_supports( "sse2" ) )
+          result.push_back( { "sse2", &detail::XorIntoSse2 } );
+       if( __builtin_cpu_supports( "avx2" ) )
+          result.push_back( { "avx2", &detail::XorIntoAvx2 } );
+       if( __builtin_cpu_supports( "avx512f" ) )
+          result.push_back( { "avx512f", &detail::XorIntoAvx512 } );
+ #endif
+       return result;
+    }();
+    return kernels;
+ }
+
+ /**
+  * Ядро, выбранное при первом обращении (самое широкое из доступных).
+  */
+ inline const XorKernelInfo& SelectedXorKernel()
+ {
+    static const XorKernelInfo kernel = AvailableXorKernels().back();
+    return kernel;
+ }
+
+ /**
+  * Сложение по месту: dst ^= src. Короткие буферы складываются без косвенного вызова.
+  */
+ inline void XorInto( void* dst, const void* src, std::size_t n )
+ {
+    auto* d = static_cast< std::byte* >( dst );
+    const auto* s = static_cast< const std::byte* >( src );
+    if( n < 32 )
+    {
+       detail::XorIntoPortable( d, s, n );
+       return;
+    }
+    SelectedXorKernel().mKernel( d, s, n );
+ }
+
+ /**
+  * Все ли n байт равны нулю. Проверка идет блоками по 64 байта и прекращается на первом ненулевом блоке.
+  */
+ inline bool IsZero( const void* src, std::size_t n )
+ {
+    const auto* s = static_cast< const std::byte* >( src );
+    std::size_t i = 0;
+    for( ; i + 64 <= n; i += 64 )
+    {
+       std::uint64_t words[ 8 ];
+       std::memcpy( words, s + i, sizeof( words ) );
+       std::uint64_t any = 0;
+       for( auto word : words )
+          any |= word;
+       if( any != 0 )
+          return false;
+    }
+    for( ; i < n; ++i )
+       if( s[ i ] != std::byte{ 0 } )
+          return false;
+    return true;
+ }
+
+ /**
+  * Измерить пропускную способность ядра, ГБ/с (считаются байты приемника).
+  * @param n - размер буферов, байт.
+  * @param repeats - количество повторов.
+  */
+ inline double MeasureXorBandwidth( const XorKernelInfo& kernel, std::size_t n = 4096, int repeats = 100000 )
+ {
+    std::vector< std::byte > dst( n ), src( n );
+    for( std::size_t i = 0; i < n; ++i )
+    {
+       dst[ i ] = std::byte( i * 7 );
+       src[ i ] = std::byte( i * 13 + 1 );
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for( int r = 0; r < repeats; ++r )
+       kernel.mKernel( dst.data(), src.data(), n );
+    const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+    // Не даем компилятору выбросить вычисления.
+    volatile auto sink = dst[ n / 2 ];
+    (void)sink;
+    return elapsed.count() > 0 ? double( n ) * repeats / elapsed.count() * 1e-9 : 0.0;
+ }
+
+ } // namespace hamming
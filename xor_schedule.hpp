@@ -0,0 +1,264 @@
+/**
+ * @author Новиков А.В., nawww83@gmail.com.
+ */
+
+ #pragma once
+
+ #include <algorithm> // std::sort
+ #include <bit>     // std::popcount
+ #include <cstddef> // std::byte, std::size_t
+ #include <cstring> // std::memcpy, std::memset
+ #include <vector>  // std::vector
+
+ #include "bit_matrix.hpp"
+ #include "xor_kernels.hpp"
+
+ namespace hamming
+ {
+
+ /**
+  * Наибольшее количество переменных, для которых выполняется жадный поиск общих пар.
+  * Сложность одного шага поиска квадратична по количеству переменных.
+  */
+ inline constexpr int kMaxPairedVariables = 512;
+
+ /**
+  * Расписание XOR для вычисления нескольких сумм (выходов) по общим входам.
+  * Переменные 0..mInputs-1 - входы, mInputs..mInputs+mTemps-1 - промежуточные суммы,
+  * которые вычисляются один раз и используются в нескольких выходах.
+  */
+ struct XorSchedule
+ {
+    /**
+     * Промежуточная сумма: var[mDst] = var[mA] ^ var[mB]; при mA == mDst - сложение по месту var[mDst] ^= var[mB].
+     */
+    struct Op
+    {
+       int mDst = 0;
+
+       int mA = 0;
+
+       int mB = 0;
+    };
+
+    int mInputs = 0;
+
+    int mTemps = 0;
+
+    std::vector< Op > mOps;
+
+    /**
+     * Слагаемые выхода i: mTerms[ mOffsets[ i ] .. mOffsets[ i + 1 ] ).
+     */
+    std::vector< int > mTerms;
+
+    std::vector< int > mOffsets;
+
+    /**
+     * Количество XOR в исходной (построчной) схеме.
+     */
+    int mNaiveXors = 0;
+
+    int Outputs() const { return static_cast< int >( mOffsets.size() ) - 1; }
+
+    bool Empty() const { return mOffsets.size() <= 1; }
+
+    /**
+     * Количество XOR по расписанию (копирование первого слагаемого не считается).
+     */
+    int XorCount() const
+    {
+       int count = mOps.size();
+       for( std::size_t i = 0; i + 1 < mOffsets.size(); ++i )
+          if( mOffsets[ i + 1 ] > mOffsets[ i ] )
+             count += mOffsets[ i + 1 ] - mOffsets[ i ] - 1;
+       return count;
+    }
+ };
+
+ /**
+  * Строит расписание XOR с исключением общих подвыражений.
+  * 1. Входы с одинаковым набором выходов (не менее двух) суммируются один раз.
+  * 2. Жадно выбирается пара переменных, входящая в наибольшее число выходов (алгоритм Паара),
+  *    пара заменяется промежуточной суммой; повторяется, пока пара встречается хотя бы дважды.
+  * @param rows - dim = (выходы x входы): строка i отмечает входы, сумма которых дает выход i.
+  */
+ inline XorSchedule MakeXorSchedule( const BitMatrix& rows )
+ {
+    const int outputs = rows.Rows();
+    const int inputs = rows.Cols();
+    const int words = ( outputs + BitMatrix::kWordBits - 1 ) / BitMatrix::kWordBits;
+    XorSchedule schedule;
+    schedule.mInputs = inputs;
+    for( int i = 0; i < outputs; ++i )
+    {
+       const int weight = rows.Weight( i );
+       schedule.mNaiveXors += weight > 0 ? weight - 1 : 0;
+    }
+    // Столбцы: для каждой переменной - множество выходов, в которые она входит (по words слов подряд).
+    std::vector< BitMatrix::Word > columns( static_cast< std::size_t >( inputs ) * words, 0 );
+    for( int i = 0; i < outputs; ++i )
+       for( int j = rows.FindInRow( i, 0, inputs ); j != -1; j = rows.FindInRow( i, j + 1, inputs ) )
+          columns[ j * words + i / BitMatrix::kWordBits ] |= BitMatrix::Word( 1 ) << ( i % BitMatrix::kWordBits );
+    auto weight_of = [&columns, words]( int v ) {
+       int weight = 0;
+       for( int w = 0; w < words; ++w )
+          weight += std::popcount( columns[ v * words + w ] );
+       return weight;
+    };
+    auto same_columns = [&columns, words]( int a, int b ) {
+       for( int w = 0; w < words; ++w )
+          if( columns[ a * words + w ] != columns[ b * words + w ] )
+             return false;
+       return true;
+    };
+    auto new_variable = [&]( int a, int b ) {
+       const int t = inputs + schedule.mTemps++;
+       schedule.mOps.push_back( { t, a, b } );
+       columns.resize( columns.size() + words, 0 );
+       return t;
+    };
+    // 1. Группы входов с одинаковыми множествами выходов: сортировка по столбцам, O(n log n).
+    std::vector< int > order;
+    for( int j = 0; j < inputs; ++j )
+       if( weight_of( j ) >= 2 )
+          order.push_back( j );
+    auto less_columns = [&columns, words]( int a, int b ) {
+       for( int w = 0; w < words; ++w )
+          if( columns[ a * words + w ] != columns[ b * words + w ] )
+             return columns[ a * words + w ] < columns[ b * words + w ];
+       return a < b;
+    };
+    std::sort( order.begin(), order.end(), less_columns );
+    for( std::size_t first = 0, last = 0; first < order.size(); first = last )
+    {
+       for( last = first + 1; last < order.size() && same_columns( order[ first ], order[ last ] ); ++last )
+          ;
+       if( last - first < 2 )
+          continue;
+       const int t = new_variable( order[ first ], order[ first + 1 ] );
+       for( std::size_t k = first + 2; k < last; ++k )
+          schedule.mOps.push_back( { t, t, order[ k ] } );
+       for( int w = 0; w < words; ++w )
+          columns[ t * words + w ] = columns[ order[ first ] * words + w ];
+       for( std::size_t k = first; k < last; ++k )
+          for( int w = 0; w < words; ++w )
+             columns[ order[ k ] * words + w ] = 0;
+    }
+    // 2. Жадное выделение общих пар.
+    std::vector< int > active;
+    for( int v = 0; v < inputs + schedule.mTemps; ++v )
+       if( weight_of( v ) >= 2 )
+          active.push_back( v );
+    while( static_cast< int >( active.size() ) <= kMaxPairedVariables )
+    {
+       int best = 1, best_a = -1, best_b = -1;
+       for( std::size_t x = 0; x < active.size(); ++x )
+       {
+          const BitMatrix::Word* cx = columns.data() + active[ x ] * words;
+          for( std::size_t y = x + 1; y < active.size(); ++y )
+          {
+             const BitMatrix::Word* cy = columns.data() + active[ y ] * words;
+             int count = std::popcount( cx[ 0 ] & cy[ 0 ] );
+             for( int w = 1; w < words; ++w )
+                count += std::popcount( cx[ w ] & cy[ w ] );
+             if( count > best )
+             {
+                best = count;
+                best_a = active[ x ];
+                best_b = active[ y ];
+             }
+          }
+       }
+       if( best_a == -1 )
+          break;
+       const int t = new_variable( best_a, best_b );
+       for( int w = 0; w < words; ++w )
+       {
+          const auto common = columns[ best_a * words + w ] & columns[ best_b * words + w ];
+          columns[ t * words + w ] = common;
+          columns[ best_a * words + w ] &= ~common;
+          columns[ best_b * words + w ] &= ~common;
+       }
+       std::erase_if( active, [&]( int v ) { return weight_of( v ) < 2; } );
+       active.push_back( t );
+    }
+    // Выходы: переменные, оставшиеся в столбцах.
+    schedule.mOffsets.push_back( 0 );
+    for( int i = 0; i < outputs; ++i )
+    {
+       for( int v = 0; v < inputs + schedule.mTemps; ++v )
+          if( ( columns[ v * words + i / BitMatrix::kWordBits ] >> ( i % BitMatrix::kWordBits ) ) & 1 )
+             schedule.mTerms.push_back( v );
+       schedule.mOffsets.push_back( schedule.mTerms.size() );
+    }
+    return schedule;
+ }
+
+ /**
+  * Рабочий буфер промежуточных сумм текущего потока; растет по мере необходимости и не освобождается.
+  */
+ inline std::byte* XorScratch( std::size_t bytes )
+ {
+    thread_local std::vector< std::byte > scratch;
+    if( scratch.size() < bytes )
+       scratch.resize( bytes );
+    return scratch.data();
+ }
+
+ /**
+  * Размер порции символа, которой выполняется расписание: промежуточные суммы порции должны оставаться в кэше.
+  */
+ inline std::size_t XorScheduleChunk( const XorSchedule& schedule, std::size_t bytes )
+ {
+    constexpr std::size_t kCacheBytes = 256 * 1024;
+    constexpr std::size_t kMinChunk = 1024;
+    if( schedule.mTemps == 0 )
+       return bytes;
+    std::size_t chunk = kCacheBytes / schedule.mTemps;
+    chunk = chunk < kMinChunk ? kMinChunk : chunk - chunk % 64;
+    return chunk < bytes ? chunk : bytes;
+ }
+
+ /**
+  * Выполнить расписание.
+  * @param input - указатель на символ входа j (const std::byte*).
+  * @param output - указатель на символ выхода i (std::byte*).
+  * @param bytes - размер символа, байт. Длинные символы обрабатываются порциями.
+  */
+ template< typename Input, typename Output >
+ inline void ApplyXorSchedule( const XorSchedule& schedule, Input input, Output output, std::size_t bytes )
+ {
+    const std::size_t chunk = XorScheduleChunk( schedule, bytes );
+    std::byte* temps = schedule.mTemps > 0 ? XorScratch( schedule.mTemps * chunk ) : nullptr;
+    for( std::size_t offset = 0; offset < bytes; offset += chunk )
+    {
+       const std::size_t n = bytes - offset < chunk ? bytes - offset : chunk;
+       auto variable = [&]( int v ) -> const std::byte* {
+          return v < schedule.mInputs ? input( v ) + offset : temps + ( v - schedule.mInputs ) * chunk;
+       };
+       for( const auto& op : schedule.mOps )
+       {
+          std::byte* dst = temps + ( op.mDst - schedule.mInputs ) * chunk;
+          if( op.mA != op.mDst )
+             std::memcpy( dst, variable( op.mA ), n );
+          XorInto( dst, variable( op.mB ), n );
+       }
+       for( int i = 0; i < schedule.Outputs(); ++i )
+       {
+          std::byte* dst = output( i ) + offset;
+          const int first = schedule.mOffsets[ i ];
+          const int last = schedule.mOffsets[ i + 1 ];
+          if( first == last )
+          {
+             std::memset( dst, 0, n );
+             continue;
+          }
+          std::memcpy( dst, variable( schedule.mTerms[ first ] ), n );
+          for( int s = first + 1; s < last; ++s )
+             XorInto( dst, variable( schedule.mTerms[ s ] ), n );
+       }
+    }
+ }
+
+ } // namespace hamming